@@ -0,0 +1,79 @@
+/**
+ * Micro-benchmark of documentation command lookup, as in
+ * Parser::translate(). Compares command(), the perfect hash of Command.hpp,
+ * with a linear scan of the same names in the same order, which is how
+ * commands were dispatched before, as an if-chain.
+ *
+ * The corpus is every command used in the source files given as arguments,
+ * by default those of the demo, so that the mix of commands and misses
+ * (e.g. LaTeX) is that of real documentation. Build with `cmake --build .
+ * --target bench-commands` and run from the root of the repository.
+ */
+#include "Command.hpp"
+
+/**
+ * Lookup by linear scan.
+ */
+[[gnu::noinline]] static Command linear(const std::string_view& name) {
+  for (auto& [key, value] : command_names) {
+    if (key == name) {
+      return value;
+    }
+  }
+  return Command::NONE;
+}
+
+/**
+ * Lookup by perfect hash.
+ */
+[[gnu::noinline]] static Command hashed(const std::string_view& name) {
+  return command(name);
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files(argv + 1, argv + argc);
+  if (files.empty()) {
+    files = {"demo/parsing.hpp", "demo/presentation.hpp"};
+  }
+
+  /* commands, as Tokenizer finds them, without the leading @ or \ */
+  static const std::regex regex(R"([@\\](param(\[in\]|\[out\]|\[in,out\])?|)"
+      R"(\w+|f\$|f\[|f\]|@|/))");
+  std::vector<std::string> names;
+  for (auto& file : files) {
+    std::ifstream in(file);
+    std::stringstream buf;
+    buf << in.rdbuf();
+    std::string source = buf.str();
+    for (auto iter = std::sregex_iterator(source.begin(), source.end(),
+        regex); iter != std::sregex_iterator(); ++iter) {
+      names.push_back(iter->str().substr(1));
+    }
+  }
+  if (names.empty()) {
+    std::cerr << "no commands found" << std::endl;
+    return 1;
+  }
+
+  /* repeat the corpus to at least ten million lookups */
+  const size_t reps = (10000000 + names.size() - 1)/names.size();
+  auto time = [&](Command (*lookup)(const std::string_view&)) {
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) {
+      for (auto& name : names) {
+        hits += lookup(name) != Command::NONE;
+      }
+    }
+    std::chrono::duration<double,std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << std::fixed << std::setprecision(1) <<
+        elapsed.count()/(reps*names.size()) << " ns/lookup (" <<
+        hits/reps << " of " << names.size() << " known)" << std::endl;
+  };
+  std::cout << "linear: ";
+  time(linear);
+  std::cout << "hashed: ";
+  time(hashed);
+  return 0;
+}
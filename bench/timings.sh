@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# Time `doxide build` at each of the given revisions, e.g.
+#
+#     bench/timings.sh HEAD~1 HEAD
+#
+# Each revision is checked out into a worktree with its submodules and
+# built in release mode. It is then run REPS times (default 5) in the
+# project directory PROJECT (default the root of this repository, which
+# documents demo/). For each revision, this prints the best wall time, the
+# peak RSS of that run, and the summary that doxide prints. The summary
+# includes parse error, reparse and expansion counts. Further options for
+# doxide, e.g. FLAGS="--jobs 8", are passed through. Requires GNU time.
+#
+set -e
+root=$(git rev-parse --show-toplevel)
+project=${PROJECT:-$root}
+reps=${REPS:-5}
+work=$(mktemp -d)
+trap 'rm -rf "$work"; git -C "$root" worktree prune' EXIT
+
+for rev in "$@"; do
+  tree="$work/$rev"
+  git -C "$root" worktree add --detach "$tree" "$rev" > /dev/null
+  git -C "$tree" submodule update --init --recursive > /dev/null
+  cmake -S "$tree" -B "$tree/build" -DCMAKE_BUILD_TYPE=Release > /dev/null
+  cmake --build "$tree/build" -j"$(nproc)" > /dev/null
+  doxide="$tree/build/doxide"
+
+  # parse everything on each run, where the revision has a cache
+  flags=${FLAGS:-}
+  if "$doxide" --help | grep -q -- --no-cache; then
+    flags="$flags --no-cache"
+  fi
+
+  best=""
+  i=0
+  while [ "$i" -lt "$reps" ]; do
+    out="$work/out"
+    (cd "$project" && /usr/bin/time -f '%e %M' -o "$work/time" \
+        "$doxide" $flags --output "$work/docs" build) > "$out" 2>&1
+    read -r secs kib < "$work/time"
+    if [ -z "$best" ] || awk "BEGIN { exit !($secs < $best) }"; then
+      best=$secs
+      rss=$kib
+      cp "$out" "$work/best"
+    fi
+    i=$((i + 1))
+  done
+  echo "$rev: best of $reps ${best}s, peak RSS $((rss/1024)) MiB"
+  grep -v 'warning:' "$work/best" | sed 's/^/    /'
+done
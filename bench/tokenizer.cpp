@@ -0,0 +1,96 @@
+/**
+ * Micro-benchmark of comment tokenization. Compares Tokenizer, the
+ * hand-written scanner, with RegexTokenizer, the regular expressions that
+ * it replaced, in megabytes of comments per second.
+ *
+ * The corpus is every documentation comment in the source files given as
+ * arguments, by default those of the demo, less any that have a character
+ * that starts no token, on which Tokenizer exits with an error. Build with
+ * `cmake --build . --target bench-tokenizer` and run from the root of the
+ * repository.
+ */
+#include "Tokenizer.hpp"
+#include "RegexTokenizer.hpp"
+
+/**
+ * Count tokens with the scanner.
+ */
+[[gnu::noinline]] static size_t scanned(const std::string_view& comment) {
+  size_t count = 0;
+  Tokenizer tokenizer(comment);
+  while (tokenizer.next().type) {
+    ++count;
+  }
+  return count;
+}
+
+/**
+ * Count tokens with the regular expressions.
+ */
+[[gnu::noinline]] static size_t matched(const std::string_view& comment) {
+  size_t count = 0;
+  RegexTokenizer tokenizer(comment);
+  while (tokenizer.next().type) {
+    ++count;
+  }
+  return count;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files(argv + 1, argv + argc);
+  if (files.empty()) {
+    files = {"demo/parsing.hpp", "demo/presentation.hpp"};
+  }
+
+  /* documentation comments, as Parser finds them */
+  static const std::regex regex(R"(/\*[*!][\s\S]*?\*/|//[/!][^\n]*)");
+  std::vector<std::string> comments;
+  size_t bytes = 0;
+  for (auto& file : files) {
+    std::ifstream in(file);
+    std::stringstream buf;
+    buf << in.rdbuf();
+    std::string source = buf.str();
+    for (auto iter = std::sregex_iterator(source.begin(), source.end(),
+        regex); iter != std::sregex_iterator(); ++iter) {
+      std::string comment = iter->str();
+      RegexTokenizer tokenizer(comment);
+      while (tokenizer.next().type) {
+        //
+      }
+      if (!tokenizer.failed) {
+        bytes += comment.size();
+        comments.push_back(std::move(comment));
+      }
+    }
+  }
+  if (comments.empty()) {
+    std::cerr << "no comments found" << std::endl;
+    return 1;
+  }
+
+  /* repeat the corpus to at least ten megabytes for the scanner, and one
+   * for the regular expressions, which are much slower */
+  auto time = [&](size_t (*tokenize)(const std::string_view&),
+      const size_t target) {
+    const size_t reps = (target + bytes - 1)/bytes;
+    size_t tokens = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) {
+      for (auto& comment : comments) {
+        tokens += tokenize(comment);
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << std::fixed << std::setprecision(1) <<
+        reps*bytes/1.0e6/elapsed.count() << " MB/s (" << tokens/reps <<
+        " tokens in " << comments.size() << " comments, " << bytes <<
+        " bytes)" << std::endl;
+  };
+  std::cout << "regex:   ";
+  time(matched, 1000000);
+  std::cout << "scanner: ";
+  time(scanned, 10000000);
+  return 0;
+}
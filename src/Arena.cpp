@@ -0,0 +1,179 @@
+#include "Arena.hpp"
+
+thread_local Arena* Arena::active = nullptr;
+
+Arena::Scope::Scope(Arena& arena) :
+    arena(arena) {
+  assert(!active);
+  active = &arena;
+}
+
+Arena::Scope::~Scope() {
+  active = nullptr;
+  arena.reset();
+}
+
+Arena::Arena() :
+    current(0) {
+  freed.fill(nullptr);
+}
+
+Arena::Arena(const Arena&) :
+    Arena() {
+  //
+}
+
+Arena::~Arena() {
+  for (auto& block : blocks) {
+    std::free(block.data);
+  }
+}
+
+void Arena::install() {
+  ts_set_allocator(malloc, calloc, realloc, free);
+}
+
+void* Arena::allocate(const size_t size) {
+  const size_t c = sizeClass(size);
+  Header* header = freed[c];
+  if (header) {
+    /* reuse from the free list */
+    freed[c] = *reinterpret_cast<Header**>(header + 1);
+  } else {
+    /* bump */
+    const size_t need = sizeof(Header) + capacity(c);
+    while (current < blocks.size() &&
+        blocks[current].size - blocks[current].used < need) {
+      ++current;
+    }
+    if (current == blocks.size()) {
+      char* data = static_cast<char*>(std::malloc(blockSize));
+      if (!data) {
+        return nullptr;
+      }
+      blocks.push_back({data, blockSize, 0});
+    }
+    Block& block = blocks[current];
+    header = reinterpret_cast<Header*>(block.data + block.used);
+    block.used += need;
+    header->size = capacity(c);
+    header->owner = this;
+  }
+  return header + 1;
+}
+
+void* Arena::reallocate(Header* header, const size_t size) {
+  if (size <= header->size) {
+    /* fits in the capacity of its class */
+    return header + 1;
+  }
+  void* ptr = malloc(size);
+  if (ptr) {
+    std::memcpy(ptr, header + 1, header->size);
+    release(header);
+  }
+  return ptr;
+}
+
+void Arena::release(Header* header) {
+  const size_t c = sizeClass(header->size);
+  *reinterpret_cast<Header**>(header + 1) = freed[c];
+  freed[c] = header;
+}
+
+void Arena::reset() {
+  size_t total = 0;
+  size_t n = 0;
+  while (n < blocks.size() && total + blocks[n].size <= retainSize) {
+    total += blocks[n].size;
+    blocks[n].used = 0;
+    ++n;
+  }
+  for (size_t i = n; i < blocks.size(); ++i) {
+    std::free(blocks[i].data);
+  }
+  blocks.resize(n);
+  current = 0;
+  freed.fill(nullptr);
+}
+
+size_t Arena::sizeClass(const size_t size) {
+  if (size <= 16) {
+    return 0;
+  } else if (size <= 32) {
+    return 1;
+  } else {
+    /* 2^(b - 1) < size <= 2^b, and b >= 6 */
+    int b = std::bit_width(size - 1);
+    return 2*(b - 6) + ((size <= size_t(3) << (b - 2)) ? 2 : 3);
+  }
+}
+
+size_t Arena::capacity(const size_t c) {
+  if (c < 2) {
+    return size_t(16) << c;
+  } else {
+    return size_t((c % 2 == 0) ? 48 : 64) << ((c - 2)/2);
+  }
+}
+
+void* Arena::malloc(size_t size) {
+  if (active && size <= maxSize) {
+    return active->allocate(size);
+  }
+  Header* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+  if (!header) {
+    return nullptr;
+  }
+  header->size = size;
+  header->owner = nullptr;
+  return header + 1;
+}
+
+void* Arena::calloc(size_t count, size_t size) {
+  if (size > 0 && count > std::numeric_limits<size_t>::max()/size) {
+    return nullptr;
+  }
+  void* ptr = malloc(count*size);
+  if (ptr) {
+    std::memset(ptr, 0, count*size);
+  }
+  return ptr;
+}
+
+void* Arena::realloc(void* ptr, size_t size) {
+  if (!ptr) {
+    return malloc(size);
+  }
+  Header* header = static_cast<Header*>(ptr) - 1;
+  if (!header->owner) {
+    /* heap allocation, stays on the heap */
+    header = static_cast<Header*>(std::realloc(header,
+        sizeof(Header) + size));
+    if (!header) {
+      return nullptr;
+    }
+    header->size = size;
+    return header + 1;
+  } else if (header->owner == active) {
+    return active->reallocate(header, size);
+  } else {
+    /* allocation from an arena that is no longer active, move it */
+    void* to = malloc(size);
+    if (to) {
+      std::memcpy(to, ptr, std::min(header->size, size));
+    }
+    return to;
+  }
+}
+
+void Arena::free(void* ptr) {
+  if (ptr) {
+    Header* header = static_cast<Header*>(ptr) - 1;
+    if (!header->owner) {
+      std::free(header);
+    } else if (header->owner == active) {
+      active->release(header);
+    }
+  }
+}
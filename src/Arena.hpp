@@ -0,0 +1,206 @@
+#pragma once
+
+#include "doxide.hpp"
+
+/**
+ * Memory arena for tree-sitter allocations.
+ * 
+ * Once install() is called, all tree-sitter allocations go through this
+ * class. Small allocations made on a thread within a Scope are taken from
+ * the arena of that scope: each size is rounded up to a size class, and
+ * taken from the free list of that class or, if empty, by bumping a
+ * pointer. Freed allocations go back on the free list, so that memory of a
+ * tree deleted after a reparse is reused by the next, and the whole arena
+ * is reset when the scope ends. Large allocations, and those made outside
+ * any scope, such as for the query shared between threads, go to the heap
+ * as usual.
+ * 
+ * Anything allocated within a scope, such as parsers, trees and cursors,
+ * must therefore be deleted before the scope ends. A few blocks are kept
+ * for reuse by the next scope, so that parsing file after file on the same
+ * thread seldom returns to the system allocator.
+ */
+class Arena {
+public:
+  /**
+   * Allocations within an arena, from construction to destruction.
+   */
+  class Scope {
+  public:
+    /**
+     * Constructor.
+     * 
+     * @param arena Arena from which to allocate on this thread.
+     */
+    Scope(Arena& arena);
+
+    /**
+     * Destructor. Resets the arena.
+     */
+    ~Scope();
+
+  private:
+    /**
+     * Arena.
+     */
+    Arena& arena;
+  };
+
+  /**
+   * Constructor.
+   */
+  Arena();
+
+  /**
+   * Copy constructor. The new arena is empty.
+   */
+  Arena(const Arena& o);
+
+  /**
+   * Destructor.
+   */
+  ~Arena();
+
+  /**
+   * Install arena allocation for tree-sitter. Must be called before any
+   * tree-sitter object is created.
+   */
+  static void install();
+
+private:
+  /**
+   * Header preceding each allocation.
+   */
+  struct alignas(std::max_align_t) Header {
+    /**
+     * Size of the allocation, excluding the header. For an allocation from
+     * an arena, this is the capacity of its size class.
+     */
+    size_t size;
+
+    /**
+     * Arena from which the allocation was made, or `nullptr` for the heap.
+     */
+    Arena* owner;
+  };
+
+  /**
+   * Block of memory.
+   */
+  struct Block {
+    /**
+     * Memory.
+     */
+    char* data;
+
+    /**
+     * Size of the block, in bytes.
+     */
+    size_t size;
+
+    /**
+     * Number of bytes used.
+     */
+    size_t used;
+  };
+
+  /**
+   * Allocate from the arena.
+   */
+  void* allocate(const size_t size);
+
+  /**
+   * Resize an allocation from the arena.
+   */
+  void* reallocate(Header* header, const size_t size);
+
+  /**
+   * Release an allocation from the arena to the free list of its class.
+   */
+  void release(Header* header);
+
+  /**
+   * Size class of an allocation.
+   * 
+   * @param size Size of the allocation, at most `maxSize`.
+   * 
+   * @return Index of the size class.
+   * 
+   * Classes are 16 and 32 bytes, then two for each power of two, 48, 64,
+   * 96, 128, and so on, so that at most a third of an allocation is unused,
+   * and each is a multiple of the header alignment.
+   */
+  static size_t sizeClass(const size_t size);
+
+  /**
+   * Capacity of a size class.
+   */
+  static size_t capacity(const size_t c);
+
+  /**
+   * Reset the arena, releasing all allocations at once.
+   */
+  void reset();
+
+  /**
+   * Allocation function for tree-sitter.
+   */
+  static void* malloc(size_t size);
+
+  /**
+   * Zero-initialized allocation function for tree-sitter.
+   */
+  static void* calloc(size_t count, size_t size);
+
+  /**
+   * Reallocation function for tree-sitter.
+   */
+  static void* realloc(void* ptr, size_t size);
+
+  /**
+   * Deallocation function for tree-sitter.
+   */
+  static void free(void* ptr);
+
+  /**
+   * Blocks.
+   */
+  std::vector<Block> blocks;
+
+  /**
+   * Index of the block from which to allocate next.
+   */
+  size_t current;
+
+  /**
+   * Number of size classes.
+   */
+  static constexpr size_t numClasses = 24;
+
+  /**
+   * Head of the free list of each size class. The next element of the list
+   * is stored in place of the allocation.
+   */
+  std::array<Header*,numClasses> freed;
+
+  /**
+   * Arena of the current scope on this thread, if any.
+   */
+  static thread_local Arena* active;
+
+  /**
+   * Size of a block, in bytes.
+   */
+  static constexpr size_t blockSize = 1 << 20;
+
+  /**
+   * Maximum size of an allocation from the arena, in bytes, being the
+   * capacity of the largest size class. Larger allocations go to the heap.
+   */
+  static constexpr size_t maxSize = 64 << 10;
+
+  /**
+   * Maximum total size of the blocks kept on reset, in bytes.
+   */
+  static constexpr size_t retainSize = 4 << 20;
+};
@@ -0,0 +1,233 @@
+#include "Cache.hpp"
+
+/**
+ * Magic string at the start of each cache entry, identifying the format.
+ */
+static const std::string_view magic = "doxide-cache-3\n";
+
+Cache::Cache(const std::filesystem::path& dir,
+    const define_map& defines,
+    const string_map& aliases,
+    const string_map& commands,
+    const std::string& extractor,
+    const int recoveryRounds,
+    const Entity& skeleton) :
+    dir(dir),
+    defines(defines) {
+  std::string groups;
+  write(groups, skeleton);
+
+  seed = hash(magic);
+  seed = hash(DOXIDE_VERSION, seed);
+  seed = hash(query_cpp, seed);
+  seed = hash(groups, seed);
+  seed = hash(extractor, seed);
+  seed = hash(std::string_view("\0", 1), seed);
+  seed = hash(std::to_string(recoveryRounds), seed);
+  seed = hash(std::string_view("\0", 1), seed);
+  for (auto map : {&aliases, &commands}) {
+    /* sorted, as iteration order of an unordered map is unspecified */
+    std::set<std::pair<std::string,std::string>> sorted(map->begin(),
+        map->end());
+    for (auto& [name, value] : sorted) {
+      seed = hash(name, seed);
+      seed = hash(std::string_view("\0", 1), seed);
+      seed = hash(value, seed);
+      seed = hash(std::string_view("\0", 1), seed);
+    }
+    seed = hash(std::string_view("\0", 1), seed);
+  }
+}
+
+std::string Cache::key(const std::string_view& source,
+    const std::vector<std::string>& names) const {
+  uint64_t h = hash(source, seed);
+  for (auto& name : names) {
+    h = hash(name, h);
+    h = hash(std::string_view("\0", 1), h);
+    const Define& define = defines.at(name);
+    if (define.function) {
+      h = hash(std::string_view("\0(", 2), h);
+      for (auto& param : define.params) {
+        h = hash(param, h);
+        h = hash(std::string_view("\0", 1), h);
+      }
+    }
+    h = hash(define.value, h);
+    h = hash(std::string_view("\0", 1), h);
+  }
+  std::stringstream buf;
+  buf << std::hex << std::setw(16) << std::setfill('0') << h;
+  return buf.str();
+}
+
+bool Cache::load(const std::string& key, const std::string_view& source,
+    Entity& entity) const {
+  std::filesystem::path path = dir / key;
+  if (!std::filesystem::exists(path)) {
+    return false;
+  }
+
+  std::string contents;
+  std::ifstream stream(path, std::ios::binary);
+  char buffer[4096];
+  while (stream.read(buffer, sizeof(buffer))) {
+    contents.append(buffer, sizeof(buffer));
+  }
+  contents.append(buffer, stream.gcount());
+
+  std::string_view in(contents);
+  if (!in.starts_with(magic)) {
+    return false;
+  }
+  in.remove_prefix(magic.size());
+
+  /* the key is only a 64-bit hash, so the entry also records the size and
+   * a second hash of the source, to check that it is for the same source */
+  uint64_t check[2];
+  if (in.size() < sizeof(check)) {
+    warn("ignoring corrupt cache entry " << path);
+    return false;
+  }
+  std::memcpy(check, in.data(), sizeof(check));
+  in.remove_prefix(sizeof(check));
+  if (check[0] != source.size() || check[1] != hash(source, hash(key))) {
+    return false;
+  }
+
+  Entity result;
+  if (!read(in, result) || !in.empty()) {
+    warn("ignoring corrupt cache entry " << path);
+    return false;
+  }
+  entity = std::move(result);
+
+  /* mark as recently used, see prune() */
+  std::error_code ec;
+  std::filesystem::last_write_time(path,
+      std::filesystem::file_time_type::clock::now(), ec);
+  return true;
+}
+
+void Cache::store(const std::string& key, const std::string_view& source,
+    const Entity& entity) const {
+  std::string contents(magic);
+  uint64_t check[2] = {source.size(), hash(source, hash(key))};
+  contents.append(reinterpret_cast<const char*>(check), sizeof(check));
+  write(contents, entity);
+
+  /* write to a temporary file unique to this process and thread, then
+   * rename, so that readers never see a partially-written entry */
+  static std::atomic<unsigned> counter = 0;
+  std::stringstream suffix;
+  suffix << ".tmp" << std::random_device()() << '-' << counter++;
+  std::filesystem::path path = dir / key;
+  std::filesystem::path tmp = dir / (key + suffix.str());
+  try {
+    std::filesystem::create_directories(dir);
+    std::ofstream stream(tmp, std::ios::binary);
+    stream.write(contents.data(), contents.size());
+    stream.close();
+    if (stream) {
+      std::filesystem::rename(tmp, path);
+    } else {
+      std::filesystem::remove(tmp);
+    }
+  } catch (const std::filesystem::filesystem_error& e) {
+    warn("cannot write cache entry " << path << ", " << e.what());
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+void Cache::prune() const {
+  auto cutoff = std::filesystem::file_time_type::clock::now() - maxAge;
+  std::error_code ec;
+  for (auto& file : std::filesystem::directory_iterator(dir, ec)) {
+    /* errors are ignored, as another process may have removed the file */
+    std::error_code fec;
+    if (file.is_regular_file(fec) && file.last_write_time(fec) < cutoff) {
+      std::filesystem::remove(file.path(), fec);
+    }
+  }
+}
+
+uint64_t Cache::hash(const std::string_view& str, uint64_t h) {
+  for (unsigned char c : str) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+void Cache::write(std::string& out, const std::string& str) {
+  uint32_t size = str.size();
+  out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+  out.append(str);
+}
+
+void Cache::write(std::string& out, const Entity& entity) {
+  write(out, entity.name);
+  write(out, entity.decl);
+  write(out, entity.docs);
+  write(out, entity.title);
+  write(out, entity.brief);
+  write(out, entity.ingroup);
+  out.push_back(char(entity.type));
+  out.push_back(char(entity.hide));
+  for (auto list : {&entity.namespaces, &entity.groups, &entity.types,
+      &entity.concepts, &entity.variables, &entity.functions,
+      &entity.operators, &entity.enums, &entity.macros}) {
+    uint32_t size = list->size();
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    for (auto& child : *list) {
+      write(out, child);
+    }
+  }
+}
+
+bool Cache::read(std::string_view& in, std::string& str) {
+  uint32_t size;
+  if (in.size() < sizeof(size)) {
+    return false;
+  }
+  std::memcpy(&size, in.data(), sizeof(size));
+  in.remove_prefix(sizeof(size));
+  if (in.size() < size) {
+    return false;
+  }
+  str.assign(in.substr(0, size));
+  in.remove_prefix(size);
+  return true;
+}
+
+bool Cache::read(std::string_view& in, Entity& entity) {
+  if (!read(in, entity.name) || !read(in, entity.decl) ||
+      !read(in, entity.docs) || !read(in, entity.title) ||
+      !read(in, entity.brief) || !read(in, entity.ingroup) ||
+      in.size() < 2) {
+    return false;
+  }
+  if (uint8_t(in[0]) > uint8_t(EntityType::MACRO) || uint8_t(in[1]) > 1) {
+    return false;
+  }
+  entity.type = EntityType(in[0]);
+  entity.hide = in[1];
+  in.remove_prefix(2);
+  for (auto list : {&entity.namespaces, &entity.groups, &entity.types,
+      &entity.concepts, &entity.variables, &entity.functions,
+      &entity.operators, &entity.enums, &entity.macros}) {
+    uint32_t size;
+    if (in.size() < sizeof(size)) {
+      return false;
+    }
+    std::memcpy(&size, in.data(), sizeof(size));
+    in.remove_prefix(sizeof(size));
+    for (uint32_t i = 0; i < size; ++i) {
+      if (!read(in, list->emplace_back())) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "doxide.hpp"
+#include "Entity.hpp"
+#include "Define.hpp"
+
+/**
+ * On-disk cache of parse results.
+ *
+ * Each entry holds the entities parsed from a single file, keyed by a hash of
+ * the file contents together with everything else that can affect the parse:
+ * the defines that the file references, the query, the group structure, the
+ * extraction engine and number of recovery rounds, the aliases and custom
+ * commands, and the version of Doxide. Changing a define therefore only
+ * invalidates the entries of files that reference it. Entries are written
+ * atomically (write then rename), so that several processes may share the same
+ * cache directory. Entries not used for some time are removed by prune().
+ */
+class Cache {
+public:
+  /**
+   * Constructor.
+   *
+   * @param dir Cache directory.
+   * @param defines Defines.
+   * @param aliases Aliases for commands.
+   * @param commands Custom commands.
+   * @param extractor Extraction engine.
+   * @param recoveryRounds Maximum number of error recovery rounds.
+   * @param skeleton Group structure into which files are parsed.
+   */
+  Cache(const std::filesystem::path& dir,
+      const define_map& defines,
+      const string_map& aliases,
+      const string_map& commands,
+      const std::string& extractor,
+      const int recoveryRounds,
+      const Entity& skeleton);
+
+  /**
+   * Compute the key for a file.
+   *
+   * @param source Contents of the file.
+   * @param names Names of the defines referenced by the file, sorted.
+   *
+   * @return Key.
+   * 
+   * @see Parser::references()
+   */
+  std::string key(const std::string_view& source,
+      const std::vector<std::string>& names) const;
+
+  /**
+   * Load an entry.
+   *
+   * @param key Key.
+   * @param source Contents of the file, to check the entry against.
+   * @param[out] entity Entity into which to load the entry.
+   *
+   * @return True if the entry was found and loaded, false otherwise.
+   */
+  bool load(const std::string& key, const std::string_view& source,
+      Entity& entity) const;
+
+  /**
+   * Store an entry.
+   *
+   * @param key Key.
+   * @param source Contents of the file.
+   * @param entity Entity to store.
+   */
+  void store(const std::string& key, const std::string_view& source,
+      const Entity& entity) const;
+
+  /**
+   * Remove entries that have not been stored or loaded within `maxAge`,
+   * including those left by previous versions of Doxide.
+   */
+  void prune() const;
+
+  /**
+   * Age after which an unused entry is removed by prune().
+   */
+  static constexpr auto maxAge = std::chrono::days(30);
+
+private:
+  /**
+   * Hash a string (64-bit FNV-1a).
+   *
+   * @param str String.
+   * @param h Hash to continue from.
+   */
+  static uint64_t hash(const std::string_view& str,
+      uint64_t h = 14695981039346656037ull);
+
+  /**
+   * Serialize an entity.
+   */
+  static void write(std::string& out, const Entity& entity);
+
+  /**
+   * Serialize a string.
+   */
+  static void write(std::string& out, const std::string& str);
+
+  /**
+   * Deserialize an entity.
+   *
+   * @return False if the input is malformed.
+   */
+  static bool read(std::string_view& in, Entity& entity);
+
+  /**
+   * Deserialize a string.
+   *
+   * @return False if the input is malformed.
+   */
+  static bool read(std::string_view& in, std::string& str);
+
+  /**
+   * Cache directory.
+   */
+  std::filesystem::path dir;
+
+  /**
+   * Defines.
+   */
+  const define_map& defines;
+
+  /**
+   * Hash of everything other than the file contents that goes into a key.
+   */
+  uint64_t seed;
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "doxide.hpp"
+
+/**
+ * Documentation commands, by how they are translated. Several command names
+ * may share the same translation.
+ */
+enum class Command : uint8_t {
+  NONE,
+  PARAM,
+  PARAM_OUT,
+  PARAM_IN_OUT,
+  TPARAM,
+  CODE,
+  RETURN,
+  PRE,
+  POST,
+  THROW,
+  SEE,
+  ANCHOR,
+  ADMONITION,
+  INGROUP,
+  RETURNS,
+  FILE,
+  INTERNAL,
+  BRIEF,
+  EMPHASIS,
+  BOLD,
+  MATH_INLINE,
+  MATH_BLOCK,
+  ITEM,
+  REF,
+  FENCE,
+  ATTENTION,
+  TODO,
+  REMARK,
+  IGNORE,
+  AT,
+  SLASH
+};
+
+/**
+ * Command names and their translations.
+ */
+static constexpr std::pair<std::string_view,Command> command_names[] = {
+  /* non-legacy commands */
+  {"param", Command::PARAM},
+  {"param[in]", Command::PARAM},
+  {"param[out]", Command::PARAM_OUT},
+  {"param[in,out]", Command::PARAM_IN_OUT},
+  {"tparam", Command::TPARAM},
+  {"p", Command::CODE},
+  {"return", Command::RETURN},
+  {"pre", Command::PRE},
+  {"post", Command::POST},
+  {"throw", Command::THROW},
+  {"see", Command::SEE},
+  {"anchor", Command::ANCHOR},
+  {"note", Command::ADMONITION},
+  {"abstract", Command::ADMONITION},
+  {"info", Command::ADMONITION},
+  {"tip", Command::ADMONITION},
+  {"success", Command::ADMONITION},
+  {"question", Command::ADMONITION},
+  {"warning", Command::ADMONITION},
+  {"failure", Command::ADMONITION},
+  {"danger", Command::ADMONITION},
+  {"bug", Command::ADMONITION},
+  {"example", Command::ADMONITION},
+  {"quote", Command::ADMONITION},
+  {"ingroup", Command::INGROUP},
+
+  /* legacy commands */
+  {"returns", Command::RETURNS},
+  {"result", Command::RETURNS},
+  {"sa", Command::SEE},
+  {"file", Command::FILE},
+  {"internal", Command::INTERNAL},
+  {"brief", Command::BRIEF},
+  {"short", Command::BRIEF},
+  {"e", Command::EMPHASIS},
+  {"em", Command::EMPHASIS},
+  {"a", Command::EMPHASIS},
+  {"b", Command::BOLD},
+  {"c", Command::CODE},
+  {"f$", Command::MATH_INLINE},
+  {"f[", Command::MATH_BLOCK},
+  {"f]", Command::MATH_BLOCK},
+  {"li", Command::ITEM},
+  {"arg", Command::ITEM},
+  {"ref", Command::REF},
+  {"code", Command::FENCE},
+  {"endcode", Command::FENCE},
+  {"verbatim", Command::FENCE},
+  {"endverbatim", Command::FENCE},
+  {"attention", Command::ATTENTION},
+  {"todo", Command::TODO},
+  {"remark", Command::REMARK},
+  {"def", Command::IGNORE},
+  {"var", Command::IGNORE},
+  {"fn", Command::IGNORE},
+  {"class", Command::IGNORE},
+  {"struct", Command::IGNORE},
+  {"union", Command::IGNORE},
+  {"enum", Command::IGNORE},
+  {"typedef", Command::IGNORE},
+  {"namespace", Command::IGNORE},
+  {"interface", Command::IGNORE},
+  {"protocol", Command::IGNORE},
+  {"property", Command::IGNORE},
+  {"@", Command::AT},
+  {"/", Command::SLASH}
+};
+
+/**
+ * Seeded hash of a command name.
+ */
+constexpr uint32_t command_hash(const std::string_view& name,
+    const uint32_t seed) {
+  /* FNV-1a, folded */
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : name) {
+    h ^= (unsigned char)c;
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+/**
+ * Perfect hash table of command names, generated at compile time.
+ */
+struct CommandTable {
+  /**
+   * Number of slots, a power of two.
+   */
+  static constexpr uint32_t size = 1024;
+
+  /**
+   * Seed for which no two command names hash to the same slot.
+   */
+  uint32_t seed;
+
+  /**
+   * Slots, each one more than the index of the command name in `command_names`,
+   * or zero if empty.
+   */
+  std::array<uint8_t,size> slots;
+};
+
+/**
+ * Command table. The seed is found by trying each in turn until there are
+ * no collisions, which, with the table much larger than the number of
+ * names, takes only a few tries.
+ */
+static constexpr CommandTable command_table = []() {
+  static_assert(std::size(command_names) < 256);
+  for (uint32_t seed = 0; ; ++seed) {
+    CommandTable table{seed, {}};
+    bool perfect = true;
+    for (size_t i = 0; i < std::size(command_names) && perfect; ++i) {
+      uint32_t slot = command_hash(command_names[i].first, seed) &
+          (CommandTable::size - 1);
+      perfect = table.slots[slot] == 0;
+      table.slots[slot] = uint8_t(i + 1);
+    }
+    if (perfect) {
+      return table;
+    }
+  }
+}();
+
+/**
+ * Look up a command by name.
+ *
+ * @param name Command name, without the leading `@` or `\`.
+ *
+ * @return Translation of the command, or `Command::NONE` if it is not a
+ * built-in command.
+ *
+ * This costs one hash and at most one string comparison, whatever the
+ * command.
+ */
+inline Command command(const std::string_view& name) {
+  uint32_t slot = command_hash(name, command_table.seed) &
+      (CommandTable::size - 1);
+  uint8_t i = command_table.slots[slot];
+  if (i > 0 && command_names[i - 1].first == name) {
+    return command_names[i - 1].second;
+  }
+  return Command::NONE;
+}
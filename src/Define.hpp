@@ -0,0 +1,30 @@
+#pragma once
+
+#include "doxide.hpp"
+
+/**
+ * Preprocessor define, as given in the configuration file.
+ */
+struct Define {
+  /**
+   * Replacement.
+   */
+  std::string value;
+
+  /**
+   * Parameter names, for a function-like define. The last may be `...`, in
+   * which case the remaining arguments replace `__VA_ARGS__`.
+   */
+  std::vector<std::string> params;
+
+  /**
+   * Is this a function-like define, i.e. given as `NAME(params)`?
+   */
+  bool function;
+};
+
+/**
+ * Map of defines, from name to define.
+ */
+using define_map = std::unordered_map<std::string,Define,string_hash,
+    std::equal_to<>>;
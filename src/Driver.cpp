@@ -1,11 +1,22 @@
 #include "Driver.hpp"
 #include "YAMLParser.hpp"
 #include "Parser.hpp"
+#include "Arena.hpp"
+#include "Cache.hpp"
+#include "Splitter.hpp"
 #include "MarkdownGenerator.hpp"
 
 Driver::Driver() :
     title("Untitled"),
-    output("docs") {
+    output("docs"),
+    cache(".doxide-cache"),
+    jobs(1),
+    noCache(false),
+    extractor("query"),
+    matchLimit(0),
+    chunkSize(0),
+    timeBudget(0),
+    recoveryRounds(8) {
   config();
 }
 
@@ -31,25 +42,194 @@ void Driver::init() {
 }
 
 void Driver::build() {
-  clean();
+  std::vector<Variant> builds = targets();
+  for (auto& variant : builds) {
+    clean(variant.output);
+  }
+
+  /* tasks, in file order; a file larger than the chunk size is split into
+   * chunks, each a separate task, so that its parse is spread over threads,
+   * while other files are read by whichever thread gets to them */
+  struct Task {
+    std::string file;
+    Chunk chunk;
+    bool split;
+  };
+  std::vector<Task> tasks;
+  int large = 0;
+  Splitter splitter(chunkSize);
+  for (auto& file : files) {
+    std::error_code ec;
+    if (chunkSize > 0 && jobs > 1 &&
+        std::filesystem::file_size(file, ec) > chunkSize && !ec) {
+      std::vector<Chunk> chunks = splitter.split(gulp(file));
+      if (chunks.size() > 1) {
+        ++large;
+        for (auto& chunk : chunks) {
+          tasks.push_back({file, std::move(chunk), true});
+        }
+        continue;
+      }
+    }
+    tasks.push_back({file, Chunk(), false});
+  }
+
+  /* parse; each task is parsed, for each variant, into its own copy of the
+   * group structure, so that @ingroup can be resolved */
+  Entity skeleton = global.skeleton();
+  std::vector<std::vector<Entity>> results(builds.size(),
+      std::vector<Entity>(tasks.size(), skeleton));
+  std::vector<Cache> entries;
+  for (auto& variant : builds) {
+    entries.emplace_back(cache, variant.defines, aliases, commands,
+        extractor, recoveryRounds, skeleton);
+  }
+  std::atomic<size_t> next = 0;
+  std::atomic<int> cached = 0;
+  std::atomic<int> skipped = 0;
+  std::atomic<int> shared = 0;
+  auto work = [&](std::vector<Parser>& parsers) {
+    for (size_t i = next++; i < tasks.size(); i = next++) {
+      Task& task = tasks[i];
+      std::string source = task.split ? std::move(task.chunk.source) :
+          gulp(task.file);
+      int offset = task.chunk.offset;
+      if (!Parser::documented(source)) {
+        /* nothing to contribute, leave the group structure as is */
+        ++skipped;
+      } else {
+        /* the cache key covers everything on which the parse depends,
+         * including the values of the defines that the source references,
+         * so variants with the same key share one parse */
+        std::vector<std::string> keys;
+        for (size_t v = 0; v < builds.size(); ++v) {
+          Parser& parser = parsers[v];
+          std::vector<Entity>& result = results[v];
+          keys.push_back(entries[v].key(source, parser.references(source)));
+          auto same = std::find(keys.begin(), keys.end() - 1, keys.back());
+          if (same != keys.end() - 1) {
+            result[i] = results[same - keys.begin()][i];
+            ++shared;
+          } else if (noCache || extractor == "check") {
+            parser.parse(task.file, source, result[i], offset);
+          } else if (entries[v].load(keys.back(), source, result[i])) {
+            ++cached;
+          } else if (parser.parse(task.file, source, result[i], offset)) {
+            entries[v].store(keys.back(), source, result[i]);
+          }
+        }
+      }
+    }
+  };
+
+  /* tree-sitter allocations are taken from per-thread arenas while
+   * parsing, see Parser::parse() */
+  Arena::install();
+  std::list<std::vector<Parser>> parsers(1);  // for each thread, variant
+  parsers.front().reserve(builds.size());
+  for (auto& variant : builds) {
+    Parser& parser = parsers.front().emplace_back(variant.defines);
+    if (extractor == "walk") {
+      parser.extractor = Extractor::WALK;
+    } else if (extractor == "check") {
+      parser.extractor = Extractor::CHECK;
+    }
+    parser.matchLimit = matchLimit;
+    parser.timeBudget = timeBudget;
+    parser.maxRecoveryRounds = recoveryRounds;
+    parser.aliases = aliases;
+    parser.commands = commands;
+  }
+  for (int i = 1; i < jobs; ++i) {
+    parsers.emplace_back(parsers.front());
+  }
+  std::vector<std::thread> threads;
+  for (auto iter = std::next(parsers.begin()); iter != parsers.end(); ++iter) {
+    threads.emplace_back(work, std::ref(*iter));
+  }
+  work(parsers.front());
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (!noCache && extractor != "check") {
+    entries.front().prune();
+  }
+  ParserStats stats;
+  for (auto& thread : parsers) {
+    for (auto& parser : thread) {
+      stats += parser.stats;
+    }
+  }
 
-  /* parse */
-  Parser parser(defines);
-  for (auto file: files) {
-    parser.parse(file, global);
+  for (size_t v = 0; v < builds.size(); ++v) {
+    /* merge, in file order, so that the result is the same regardless of
+     * the number of threads */
+    Entity root = global;
+    for (auto& result : results[v]) {
+      root.merge(std::move(result));
+    }
+
+    /* generate */
+    MarkdownGenerator generator;
+    generator.generate(builds[v].output, root);
   }
 
-  /* generate */
-  MarkdownGenerator generator;
-  generator.generate(output, global);
+  /* summary */
+  std::cout << "Parsed " << files.size() << " files as " << tasks.size() <<
+      " tasks, " << cached << " from cache, " << skipped <<
+      " skipped without documentation comments." << std::endl;
+  if (builds.size() > 1) {
+    std::cout << "Built " << builds.size() << " variants, " << shared <<
+        " parses shared between them." << std::endl;
+  }
+  if (large > 0) {
+    std::cout << "Split " << large << " files over " << chunkSize <<
+        " bytes into chunks." << std::endl;
+  }
+  if (stats.overflows > 0) {
+    std::cout << "Query match limit exceeded in " << stats.overflows <<
+        " files, see warnings." << std::endl;
+  }
+  if (stats.timeouts > 0) {
+    std::cout << "Parse time budget exceeded in " << stats.timeouts <<
+        " files, see warnings." << std::endl;
+  }
+  if (stats.expansions > 0) {
+    std::cout << "Expanded " << stats.expansions <<
+        " uses of function-like defines." << std::endl;
+  }
+  if (stats.errors > 0) {
+    std::cout << "Found " << stats.errors <<
+        " parse errors after replacing defines, see warnings." << std::endl;
+  }
+  if (stats.erasures > 0) {
+    std::cout << "Error recovery erased " << stats.erasures <<
+        " macro uses with " << stats.reparses << " reparses, " <<
+        (stats.erasures - stats.reparses) <<
+        " fewer than one reparse per use." << std::endl;
+  }
+  if (extractor == "check") {
+    if (stats.disagreements > 0) {
+      error("extraction engines disagree in " << stats.disagreements <<
+          " files, see warnings.");
+    }
+    std::cout << "Extraction engines agree on all files parsed." <<
+        std::endl;
+  }
 }
 
 void Driver::clean() {
+  for (auto& target : targets()) {
+    clean(target.output);
+  }
+}
+
+void Driver::clean(const std::filesystem::path& dir) {
   /* traverse the output directory, removing any Markdown files with
    * 'generator: doxide' in their YAML frontmatter; these are files managed by
    * Doxide */
-  if (std::filesystem::exists(output) && std::filesystem::is_directory(output)) {
-    for (auto& entry : std::filesystem::recursive_directory_iterator(output)) {
+  if (std::filesystem::exists(dir) && std::filesystem::is_directory(dir)) {
+    for (auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
       if (entry.is_regular_file() && entry.path().extension() == ".md") {
         try {
           YAMLParser parser;
@@ -70,18 +250,43 @@ void Driver::clean() {
     std::vector<std::filesystem::path> empty;
     do {
       empty.clear();
-      for (auto& entry : std::filesystem::recursive_directory_iterator(output)) {
+      for (auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
         if (entry.is_directory() && std::filesystem::is_empty(entry.path())) {
           empty.push_back(entry.path());
         }
       }
-      for (auto& dir : empty) {
-        std::filesystem::remove(dir);
+      for (auto& path : empty) {
+        std::filesystem::remove(path);
       }    
     } while (empty.size());
   }
 }
 
+std::vector<Variant> Driver::targets() const {
+  if (variants.empty()) {
+    return {{"", defines, output}};
+  }
+  /* resolved here rather than in config(), as the top-level output
+   * directory may be given on the command line */
+  std::vector<Variant> result;
+  std::unordered_set<std::string> outputs;
+  for (auto variant : variants) {
+    if (variant.output.empty()) {
+      /* default to a subdirectory of the top-level output directory */
+      variant.output = (std::filesystem::path(output) / variant.name).string();
+    }
+    auto dir = std::filesystem::path(variant.output).lexically_normal();
+    if (outputs.insert(dir.string()).second) {
+      result.push_back(std::move(variant));
+    } else {
+      /* would overwrite the documentation of another variant */
+      warn("variant " << variant.name << " has the same output directory " <<
+          "as another, skipping.");
+    }
+  }
+  return result;
+}
+
 void Driver::config() {
   /* find the configuration file */
   std::string path;
@@ -118,16 +323,100 @@ void Driver::config() {
       warn("'output' must be a value in configuration.");
     }
   }
-  if (root.has("defines")) {
-    if (root.isMapping("defines")) {
-      const auto& map = root.mapping("defines");
-      for (auto& [key, value] : map) {
-        if (value->isValue()) {
-          defines[key] = value->value();
+  if (root.has("cache")) {
+    if (root.isValue("cache")) {
+      cache = root.value("cache");
+    } else {
+      warn("'cache' must be a value in configuration.");
+    }
+  }
+  if (root.has("match_limit")) {
+    if (root.isValue("match_limit")) {
+      try {
+        matchLimit = std::stoi(root.value("match_limit"));
+      } catch (const std::logic_error&) {
+        warn("'match_limit' must be an integer in configuration.");
+      }
+      if (matchLimit < 0) {
+        warn("'match_limit' must not be negative in configuration.");
+        matchLimit = 0;
+      }
+    } else {
+      warn("'match_limit' must be a value in configuration.");
+    }
+  }
+  if (root.has("time_budget")) {
+    if (root.isValue("time_budget")) {
+      try {
+        timeBudget = std::stoi(root.value("time_budget"));
+      } catch (const std::logic_error&) {
+        warn("'time_budget' must be an integer in configuration.");
+      }
+      if (timeBudget < 0) {
+        warn("'time_budget' must not be negative in configuration.");
+        timeBudget = 0;
+      }
+    } else {
+      warn("'time_budget' must be a value in configuration.");
+    }
+  }
+  if (root.has("recovery_rounds")) {
+    if (root.isValue("recovery_rounds")) {
+      try {
+        recoveryRounds = std::stoi(root.value("recovery_rounds"));
+      } catch (const std::logic_error&) {
+        warn("'recovery_rounds' must be an integer in configuration.");
+      }
+      if (recoveryRounds < 0) {
+        warn("'recovery_rounds' must not be negative in configuration.");
+        recoveryRounds = 0;
+      }
+    } else {
+      warn("'recovery_rounds' must be a value in configuration.");
+    }
+  }
+  if (root.has("chunk_size")) {
+    if (root.isValue("chunk_size")) {
+      try {
+        chunkSize = std::stoull(root.value("chunk_size"));
+      } catch (const std::logic_error&) {
+        warn("'chunk_size' must be an integer in configuration.");
+      }
+    } else {
+      warn("'chunk_size' must be a value in configuration.");
+    }
+  }
+  strings(root, "aliases", aliases);
+  strings(root, "commands", commands);
+  definitions(root, defines);
+  if (root.has("variants")) {
+    if (root.isSequence("variants")) {
+      /* names already taken, as variants with the same name would write
+       * to the same default output directory */
+      std::unordered_set<std::string> names;
+      for (auto& node : root.sequence("variants")) {
+        Variant variant;
+        if (node->isValue("name")) {
+          variant.name = node->value("name");
+        } else {
+          warn("a variant is missing a name in the configuration file, " <<
+              "skipping.");
+          continue;
         }
+        if (node->isValue("output")) {
+          variant.output = node->value("output");
+        }
+        if (!names.insert(variant.name).second) {
+          warn("variant " << variant.name << " is already in the " <<
+              "configuration file, skipping.");
+          continue;
+        }
+        variant.defines = defines;
+        definitions(*node, variant.defines);
+        variants.push_back(std::move(variant));
       }
     } else {
-      warn("'defines' must be a mapping in configuration.");
+      warn("'variants' must be a sequence in configuration.");
     }
   }
   
@@ -178,7 +467,71 @@ void Driver::groups(YAMLNode& parentNode, Entity& parentEntity) {
         warn("a group is missing a name in the configuration file.")
       }
       groups(*node, entity);
-      parentEntity.add(entity);
+      parentEntity.add(std::move(entity));
+    }
+  }
+}
+
+void Driver::definitions(YAMLNode& parentNode, define_map& map) {
+  if (parentNode.has("defines")) {
+    if (parentNode.isMapping("defines")) {
+      const auto& mapping = parentNode.mapping("defines");
+      for (auto& [key, value] : mapping) {
+        if (value->isValue()) {
+          /* key is either NAME, or NAME(params) for a function-like define;
+           * names and params are checked to be identifiers */
+          static std::regex object(R"(\s*([A-Za-z_]\w*)\s*)");
+          static std::regex function(R"(\s*([A-Za-z_]\w*)\(([^()]*)\)\s*)");
+          static std::regex param(R"(\s*([A-Za-z_]\w*|\.\.\.)\s*)");
+          std::smatch match;
+          if (std::regex_match(key, match, object)) {
+            map[match[1]] = {value->value(), {}, false};
+          } else if (std::regex_match(key, match, function)) {
+            Define define{value->value(), {}, true};
+            std::string params = match[2];
+            bool valid = true;
+            if (params.find_first_not_of(" \t") != std::string::npos) {
+              std::stringstream stream(params);
+              std::string p;
+              while (std::getline(stream, p, ',')) {
+                std::smatch m;
+                valid = valid && std::regex_match(p, m, param) &&
+                    (define.params.empty() || define.params.back() != "...");
+                define.params.push_back(valid ? m[1].str() : p);
+              }
+              valid = valid && params.back() != ',';
+            }
+            if (valid) {
+              map[match[1]] = define;
+            } else {
+              warn("invalid parameters in define '" << key <<
+                  "' in configuration, ignoring.");
+            }
+          } else {
+            warn("invalid name for define '" << key <<
+                "' in configuration, ignoring.");
+          }
+        }
+      }
+    } else {
+      warn("'defines' must be a mapping in configuration.");
+    }
+  }
+}
+
+void Driver::strings(YAMLNode& parentNode, const std::string& key,
+    string_map& map) {
+  if (parentNode.has(key)) {
+    if (parentNode.isMapping(key)) {
+      for (auto& [name, value] : parentNode.mapping(key)) {
+        if (value->isValue()) {
+          map[name] = value->value();
+        } else {
+          warn("'" << key << "' values must be strings in configuration.");
+        }
+      }
+    } else {
+      warn("'" << key << "' must be a mapping in configuration.");
     }
   }
 }
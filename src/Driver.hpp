@@ -2,6 +2,8 @@
 
 #include "doxide.hpp"
 #include "Entity.hpp"
+#include "Define.hpp"
+#include "Variant.hpp"
 #include "YAMLNode.hpp"
 
 /**
@@ -25,7 +27,7 @@ public:
   void build();
 
   /**
-   * Clean documentation.
+   * Clean documentation, in the output directory of each variant.
    */
   void clean();
 
@@ -47,7 +49,59 @@ public:
   /**
    * Defines.
    */
-  std::unordered_map<std::string,std::string> defines;
+  define_map defines;
+
+  /**
+   * Cache directory.
+   */
+  std::string cache;
+
+  /**
+   * Number of threads to use when parsing.
+   */
+  int jobs;
+
+  /**
+   * Bypass the cache?
+   */
+  bool noCache;
+
+  /**
+   * Extraction engine, either "query" or "walk".
+   */
+  std::string extractor;
+
+  /**
+   * Maximum number of in-progress query matches, or zero for the default.
+   */
+  int matchLimit;
+
+  /**
+   * Size in bytes above which a file is split into chunks of about this
+   * size, parsed in parallel, or zero to never split.
+   */
+  size_t chunkSize;
+
+  /**
+   * Time budget for parsing each file, in milliseconds, or zero for no
+   * limit.
+   */
+  int timeBudget;
+
+  /**
+   * Maximum number of rounds of error recovery for each file.
+   */
+  int recoveryRounds;
+
+  /**
+   * Aliases for commands, from alias to command name.
+   */
+  string_map aliases;
+
+  /**
+   * Custom commands, from name to Markdown replacement.
+   */
+  string_map commands;
 
 private:
   /**
@@ -60,11 +114,46 @@ private:
    */
   void groups(YAMLNode& parentNode, Entity& parentEntity);
 
+  /**
+   * Read defines from the configuration file.
+   * 
+   * @param parentNode Node with a `defines` key.
+   * @param[in,out] map Defines, to which those read are added, replacing
+   * any of the same name.
+   */
+  void definitions(YAMLNode& parentNode, define_map& map);
+
+  /**
+   * Read a mapping of strings to strings from the configuration file.
+   *
+   * @param parentNode Node that may have the key.
+   * @param key Key.
+   * @param[out] map Mapping, to which those read are added.
+   */
+  void strings(YAMLNode& parentNode, const std::string& key, string_map& map);
+
+  /**
+   * Clean documentation in an output directory.
+   */
+  static void clean(const std::filesystem::path& dir);
+
+  /**
+   * Variants to build, each from the same files. If there are none in the
+   * configuration file, the build has a single variant with the top-level
+   * defines and output directory.
+   */
+  std::vector<Variant> targets() const;
+
   /**
    * Lists of files from config.
    */
   std::unordered_set<std::string> files;
 
+  /**
+   * Variants from config.
+   */
+  std::vector<Variant> variants;
+
   /**
    * Global namespace.
    */
@@ -26,65 +26,70 @@ bool Entity::empty() const {
   return result;
 }
 
-void Entity::add(const Entity& o) {
+bool Entity::discarded() const {
+  return type != EntityType::NONE && type != EntityType::NAMESPACE &&
+      type != EntityType::GROUP && (hide || docs.empty());
+}
+
+void Entity::add(Entity&& o) {
   if (!o.ingroup.empty()) {
-    if (addToGroup(o)) {
+    if (addToGroup(std::move(o))) {
       return;
     } else {
       warn("ignoring @ingroup " << o.ingroup << ", no such group");
     }
   }
-  addToThis(o);
+  addToThis(std::move(o));
 }
 
-bool Entity::addToGroup(const Entity& o) {
+bool Entity::addToGroup(Entity&& o) {
   /* search for immediate child of given name */
   auto iter = std::find_if(groups.begin(), groups.end(),
       [&o](const Entity& g) {
         return g.name == o.ingroup;
       });
   if (iter != groups.end()) {
-    iter->addToThis(o);
+    iter->addToThis(std::move(o));
     return true;
   }
 
   /* search recursively for descendent of given name */
   for (auto& g : groups) {
-    if (g.addToGroup(o)) {
+    if (g.addToGroup(std::move(o))) {
       return true;
     }
   }
   return false;
 }
 
-void Entity::addToThis(const Entity& o) {
+void Entity::addToThis(Entity&& o) {
   if (o.type == EntityType::NAMESPACE) {
     auto iter = std::find_if(namespaces.begin(), namespaces.end(),
         [&o](const Entity& ns) {
           return ns.name == o.name;
         });
     if (iter == namespaces.end()) {
-      namespaces.push_back(o);
+      namespaces.push_back(std::move(o));
     } else {
-      iter->merge(o);
+      iter->merge(std::move(o));
     }
   } else if (o.type == EntityType::GROUP) {
-    groups.push_back(o);
+    groups.push_back(std::move(o));
   } else if (!o.hide && !o.docs.empty()) {
     if (o.type == EntityType::TYPE) {
-      types.push_back(o);
+      types.push_back(std::move(o));
     } else if (o.type == EntityType::CONCEPT) {
-      concepts.push_back(o);
+      concepts.push_back(std::move(o));
     } else if (o.type == EntityType::VARIABLE) {
-      variables.push_back(o);
+      variables.push_back(std::move(o));
     } else if (o.type == EntityType::FUNCTION) {
-      functions.push_back(o);
+      functions.push_back(std::move(o));
     } else if (o.type == EntityType::OPERATOR) {
-      operators.push_back(o);
+      operators.push_back(std::move(o));
     } else if (o.type == EntityType::ENUMERATOR) {
-      enums.push_back(o);
+      enums.push_back(std::move(o));
     } else if (o.type == EntityType::MACRO) {
-      macros.push_back(o);
+      macros.push_back(std::move(o));
     } else if (o.type == EntityType::TEMPLATE) {
       // ignore, likely a parse error within the template declaration
     } else {
@@ -93,33 +98,55 @@ void Entity::addToThis(const Entity& o) {
   }
 }
 
-void Entity::merge(const Entity& o) {
+void Entity::merge(Entity&& o) {
   /* add namespaces via the merging logic of addToThis() */
-  std::for_each(o.namespaces.begin(), o.namespaces.end(),
-      [this](const Entity& o) {
-        this->addToThis(o);
-      });
+  for (auto& ns : o.namespaces) {
+    addToThis(std::move(ns));
+  }
+
+  /* merge groups of the same name, otherwise add */
+  for (auto& group : o.groups) {
+    auto iter = std::find_if(groups.begin(), groups.end(),
+        [&group](const Entity& g) {
+          return g.name == group.name;
+        });
+    if (iter == groups.end()) {
+      groups.push_back(std::move(group));
+    } else {
+      iter->merge(std::move(group));
+    }
+  }
 
-  groups.insert(groups.end(), o.groups.begin(), o.groups.end());
-  types.insert(types.end(), o.types.begin(), o.types.end());
-  concepts.insert(concepts.end(), o.concepts.begin(), o.concepts.end());
-  variables.insert(variables.end(), o.variables.begin(), o.variables.end());
-  functions.insert(functions.end(), o.functions.begin(), o.functions.end());
-  operators.insert(operators.end(), o.operators.begin(), o.operators.end());
-  macros.insert(macros.end(), o.macros.begin(), o.macros.end());
-  enums.insert(enums.end(), o.enums.begin(), o.enums.end());
+  /* splice other children, which does not copy them */
+  types.splice(types.end(), o.types);
+  concepts.splice(concepts.end(), o.concepts);
+  variables.splice(variables.end(), o.variables);
+  functions.splice(functions.end(), o.functions);
+  operators.splice(operators.end(), o.operators);
+  macros.splice(macros.end(), o.macros);
+  enums.splice(enums.end(), o.enums);
 
   if (ingroup.empty()) {
-    ingroup = o.ingroup;
+    ingroup = std::move(o.ingroup);
   }
   if (type == EntityType::TEMPLATE) {
     decl += " ";
     decl += o.decl;
   }
 
-  name = o.name;
+  name = std::move(o.name);
   docs += o.docs;
   brief += o.brief;
   type = o.type;
   hide = hide || o.hide;
 }
+
+Entity Entity::skeleton() const {
+  Entity o;
+  o.name = name;
+  o.type = type;
+  for (auto& group : groups) {
+    o.groups.push_back(group.skeleton());
+  }
+  return o;
+}
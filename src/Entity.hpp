@@ -39,22 +39,47 @@ struct Entity {
    */
   bool empty() const;
 
+  /**
+   * Would the entity be discarded when added to a parent? i.e. is it hidden
+   * or undocumented, and not a namespace or group.
+   * 
+   * @see addToThis()
+   */
+  bool discarded() const;
+
   /**
    * Add child entity.
    * 
-   * @param o Child entity.
+   * @param o Child entity, moved from.
    * 
    * If the child has `ingroup` set, then will search for and add to that
    * group instead.
    */
-  void add(const Entity& o);
+  void add(Entity&& o);
 
   /**
    * Merge the children of another entity into this one.
    * 
-   * @param o Other entity.
+   * @param o Other entity, moved from.
+   * 
+   * Namespaces and groups of the same name are merged recursively. Other
+   * children are spliced in, without copying.
+   */
+  void merge(Entity&& o);
+
+  /**
+   * Copy of this entity with its groups, recursively, but no other children
+   * or documentation.
+   * 
+   * This is used as a starting point for parsing a single file, so that
+   * `@ingroup` can be resolved, before merging the result into this entity.
+   */
+  Entity skeleton() const;
+
+  /**
+   * Is this entity the same as another, with all of its children?
    */
-  void merge(const Entity& o);
+  bool operator==(const Entity& o) const = default;
 
   /**
    * Add child entity to a group.
@@ -62,18 +87,19 @@ struct Entity {
    * @param o Child entity with `ingroup` set.
    * 
    * @return True if a group of the given name was found, in which case @p o
-   * will have been added to it, false otherwise.
+   * will have been moved into it, false otherwise, in which case @p o is
+   * unchanged.
    */
-  bool addToGroup(const Entity& o);
+  bool addToGroup(Entity&& o);
 
   /**
    * Add child entity.
    * 
-   * @param o Child entity.
+   * @param o Child entity, moved from.
    * 
    * If the child has `ingroup` set, it is ignored.
    */
-  void addToThis(const Entity& o);
+  void addToThis(Entity&& o);
 
   /**
    * Child namespaces.
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "doxide.hpp"
+#include "Entity.hpp"
+
+/**
+ * Match of an entity or documentation comment in C++ source, as produced by
+ * either extraction engine. Positions are byte offsets into the source.
+ */
+struct Match {
+  /**
+   * Entity type, or `NONE` for a documentation comment.
+   */
+  EntityType type;
+
+  /**
+   * Start of the entity or comment.
+   */
+  uint32_t start;
+
+  /**
+   * End of the entity declaration, which is the start of its body or value,
+   * if any, otherwise its end.
+   */
+  uint32_t middle;
+
+  /**
+   * End of the entity or comment.
+   */
+  uint32_t end;
+
+  /**
+   * Start of the entity name.
+   */
+  uint32_t nameStart;
+
+  /**
+   * End of the entity name.
+   */
+  uint32_t nameEnd;
+
+  bool operator==(const Match&) const = default;
+};
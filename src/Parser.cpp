@@ -1,148 +1,289 @@
 #include "Parser.hpp"
 #include "Tokenizer.hpp"
+#include "SourceMap.hpp"
+#include "Command.hpp"
 
-Parser::Parser(const std::unordered_map<std::string,std::string>& defines) :
+ParserStats::ParserStats() :
+    files(0),
+    expansions(0),
+    errors(0),
+    erasures(0),
+    reparses(0),
+    overflows(0),
+    timeouts(0),
+    disagreements(0) {
+  //
+}
+
+ParserStats& ParserStats::operator+=(const ParserStats& o) {
+  files += o.files;
+  expansions += o.expansions;
+  errors += o.errors;
+  erasures += o.erasures;
+  reparses += o.reparses;
+  overflows += o.overflows;
+  timeouts += o.timeouts;
+  disagreements += o.disagreements;
+  return *this;
+}
+
+Parser::Parser(const define_map& defines) :
+    extractor(Extractor::QUERY),
+    matchLimit(0),
+    timeBudget(0),
+    maxRecoveryRounds(8),
     defines(defines),
     parser(nullptr),
-    query(nullptr) {
+    exceeded(false),
+    timedOut(false),
+    quiet(false),
+    disagreement(std::numeric_limits<uint32_t>::max()),
+    minLength(std::numeric_limits<size_t>::max()),
+    maxLength(0) {
   uint32_t error_offset;
   TSQueryError error_type;
 
-  /* parser */
-  parser = ts_parser_new();
-  ts_parser_set_language(parser, tree_sitter_cpp());
+  /* prefilter for define names */
+  for (auto& [name, value] : defines) {
+    if (!name.empty()) {
+      initials.set((unsigned char)name.front());
+      minLength = std::min(minLength, name.size());
+      maxLength = std::max(maxLength, name.size());
+    }
+  }
+
+  /* grammar symbols */
+  for (auto name : {"identifier", "type_identifier", "field_identifier",
+      "namespace_identifier"}) {
+    identifiers.insert(ts_language_symbol_for_name(tree_sitter_cpp(), name,
+        strlen(name), true));
+  }
+  for (auto name : {"preproc_def", "preproc_function_def"}) {
+    definitions.insert(ts_language_symbol_for_name(tree_sitter_cpp(), name,
+        strlen(name), true));
+  }
+  comments.insert(ts_language_symbol_for_name(tree_sitter_cpp(), "comment",
+      strlen("comment"), true));
+  namespaces.insert(ts_language_symbol_for_name(tree_sitter_cpp(),
+      "namespace_definition", strlen("namespace_definition"), true));
+  for (auto name : {"translation_unit", "declaration_list",
+      "linkage_specification", "preproc_if", "preproc_ifdef", "preproc_else",
+      "preproc_elif"}) {
+    scopes.insert(ts_language_symbol_for_name(tree_sitter_cpp(), name,
+        strlen(name), true));
+  }
 
   /* query */
-  query = ts_query_new(tree_sitter_cpp(), query_cpp, strlen(query_cpp),
-      &error_offset, &error_type);
+  query.reset(ts_query_new(tree_sitter_cpp(), query_cpp, strlen(query_cpp),
+      &error_offset, &error_type), ts_query_delete);
   if (error_type != TSQueryErrorNone) {
     std::string_view from(query_cpp + error_offset, 40);
     error("invalid query starting " << from << "...");
   }
+
+  /* capture dispatch table, so that each capture in a match costs a single
+   * lookup by its id, rather than comparisons with its name */
+  uint32_t ncaptures = ts_query_capture_count(query.get());
+  captures.resize(ncaptures, Capture::ENTITY);
+  types.resize(ncaptures, EntityType::NONE);
+  for (uint32_t id = 0; id < ncaptures; ++id) {
+    uint32_t length = 0;
+    const char* str = ts_query_capture_name_for_id(query.get(), id, &length);
+    std::string_view name(str, length);
+    if (name == "docs") {
+      captures[id] = Capture::DOCS;
+    } else if (name == "name") {
+      captures[id] = Capture::NAME;
+    } else if (name == "body") {
+      captures[id] = Capture::BODY;
+    } else if (name == "value") {
+      captures[id] = Capture::VALUE;
+    } else if (name == "namespace") {
+      types[id] = EntityType::NAMESPACE;
+    } else if (name == "template") {
+      types[id] = EntityType::TEMPLATE;
+    } else if (name == "type") {
+      types[id] = EntityType::TYPE;
+    } else if (name == "concept") {
+      types[id] = EntityType::CONCEPT;
+    } else if (name == "variable") {
+      types[id] = EntityType::VARIABLE;
+    } else if (name == "function") {
+      types[id] = EntityType::FUNCTION;
+    } else if (name == "operator") {
+      types[id] = EntityType::OPERATOR;
+    } else if (name == "enumerator") {
+      types[id] = EntityType::ENUMERATOR;
+    } else if (name == "macro") {
+      types[id] = EntityType::MACRO;
+    }
+  }
+}
+
+Parser::Parser(const Parser& o) :
+    extractor(o.extractor),
+    matchLimit(o.matchLimit),
+    timeBudget(o.timeBudget),
+    maxRecoveryRounds(o.maxRecoveryRounds),
+    aliases(o.aliases),
+    commands(o.commands),
+    defines(o.defines),
+    parser(nullptr),
+    query(o.query),
+    walker(o.walker),
+    exceeded(false),
+    timedOut(false),
+    quiet(false),
+    disagreement(std::numeric_limits<uint32_t>::max()),
+    captures(o.captures),
+    types(o.types),
+    identifiers(o.identifiers),
+    definitions(o.definitions),
+    comments(o.comments),
+    namespaces(o.namespaces),
+    scopes(o.scopes),
+    initials(o.initials),
+    minLength(o.minLength),
+    maxLength(o.maxLength) {
+  //
 }
 
 Parser::~Parser() {
-  ts_query_delete(query);
-  ts_parser_delete(parser);
+  //
 }
 
-void Parser::parse(const std::string& file, Entity& global) {
-  std::string in = preprocess(file);
-  TSTree* tree = ts_parser_parse_string(parser, NULL, in.data(), in.size());
+bool Parser::parse(const std::string& file, const std::string& source,
+    Entity& global, const int offset) {
+  /* the tree-sitter parser, and everything else that tree-sitter allocates
+   * for this file, is taken from the arena, reset at the end of the scope */
+  Arena::Scope scope(arena);
+  parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_cpp());
+
+  std::string in;
+  started = std::chrono::steady_clock::now();
+  timedOut = false;
+  TSTree* tree = preprocess(file, source, in, offset);
+  ++stats.files;
+  if (timedOut) {
+    ++stats.timeouts;
+  }
   if (!tree) {
-    warn("cannot parse " << file << ", skipping");
+    if (!timedOut) {
+      warn("cannot parse " << file << ", skipping");
+    }
+    ts_parser_delete(parser);
+    parser = nullptr;
+    return false;
   }
   TSNode node = ts_tree_root_node(tree);
 
-  /* initialize state */
-  std::list<uint64_t> starts, ends;
-  std::list<Entity> entities;
+  /* extract */
+  std::vector<Match> matches;
+  exceeded = false;
+  extract(node, in, matches);
+  if (exceeded) {
+    warn("query match limit exceeded in " << file <<
+        ", extracted affected declarations again without limit");
+    ++stats.overflows;
+  }
+  bool disagrees = false;
+  if (disagreement != std::numeric_limits<uint32_t>::max()) {
+    warn("extraction engines disagree in " << file << ", first at '" <<
+        in.substr(disagreement, 40) << "'");
+    disagrees = true;
+  }
+  coalesce(in, matches);
 
-  starts.push_back(ts_node_start_byte(node));
-  ends.push_back(ts_node_end_byte(node));
-  entities.emplace_back(std::move(global));
+  /* when checking, entities are also built from the query as it runs by
+   * default, over only the parts of the tree that may be documented, which
+   * must give the same entities as the query over the whole tree */
+  Entity pruned;
+  if (extractor == Extractor::CHECK) {
+    std::vector<Match> searched;
+    search(node, in, searched);
+    coalesce(in, searched);
+    pruned = global;
+    quiet = true;  // warnings are issued for the build below
+    build(searched, in, pruned);
+    quiet = false;
+  }
+  build(matches, in, global);
+  if (extractor == Extractor::CHECK && pruned != global) {
+    warn("query gives different entities when pruned in " << file);
+    disagrees = true;
+  }
+  if (disagrees) {
+    ++stats.disagreements;
+  }
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  parser = nullptr;
+  return !timedOut;
+}
+
+void Parser::build(std::vector<Match>& matches, const std::string_view& in,
+    Entity& global) {
+  /* initialize stack with the global namespace; the name and declaration of
+   * each entity are kept as offsets into the source until it is known to be
+   * documented */
+  std::vector<Frame> frames;
+  uint32_t k = 0;
+  uint32_t l = in.size();
+  frames.push_back({std::move(global), {EntityType::NONE, k, l, l, k, k},
+      false});
 
-  /* run query */
-  TSQueryCursor* cursor = ts_query_cursor_new();
-  ts_query_cursor_exec(cursor, query, node);
-  TSQueryMatch match;
   Entity entity;
-  while (ts_query_cursor_next_match(cursor, &match)) {    
-    uint64_t start = 0, middle = 0, end = 0;
-    for (uint16_t i = 0; i < match.capture_count; ++i) {
-      node = match.captures[i].node;
-      uint32_t id = match.captures[i].index; 
-      uint32_t length = 0;
-      uint32_t k = ts_node_start_byte(node);
-      uint32_t l = ts_node_end_byte(node);
-      const char* name = ts_query_capture_name_for_id(query, id, &length);
-
-      if (strncmp(name, "docs", length) == 0) {
-        std::string docs = in.substr(k, l - k);
-        Tokenizer tokenizer(docs);
-        Token token = tokenizer.next();
-        if (token.type == AFTER_OPEN) {
-          translate(docs, entities.back());
-        } else if (token.type == BEFORE_OPEN) {
-          translate(docs, entity);
-        }
-      } else if (strncmp(name, "name", length) == 0) {
-        entity.name = in.substr(k, l - k);
-      } else if (strncmp(name, "body", length) == 0) {
-        middle = ts_node_start_byte(node);
-      } else if (strncmp(name, "value", length) == 0) {
-        middle = ts_node_start_byte(node);
-      } else {
-        start = ts_node_start_byte(node);
-        end = ts_node_end_byte(node);
-        middle = end;
-
-        if (strncmp(name, "namespace", length) == 0) {
-          entity.type = EntityType::NAMESPACE;
-        } else if (strncmp(name, "template", length) == 0) {
-          entity.type = EntityType::TEMPLATE;
-        } else if (strncmp(name, "type", length) == 0) {
-          entity.type = EntityType::TYPE;
-        } else if (strncmp(name, "concept", length) == 0) {
-          entity.type = EntityType::CONCEPT;
-        } else if (strncmp(name, "variable", length) == 0) {
-          entity.type = EntityType::VARIABLE;
-        } else if (strncmp(name, "function", length) == 0) {
-          entity.type = EntityType::FUNCTION;
-        } else if (strncmp(name, "operator", length) == 0) {
-          entity.type = EntityType::OPERATOR;
-        } else if (strncmp(name, "enumerator", length) == 0) {
-          entity.type = EntityType::ENUMERATOR;
-        } else if (strncmp(name, "macro", length) == 0) {
-          entity.type = EntityType::MACRO;
-        }
+  for (auto& match : matches) {
+    if (match.type == EntityType::NONE) {
+      /* translated in place, without copying out of the source */
+      std::string_view docs = std::string_view(in).substr(match.start,
+          match.end - match.start);
+      int type = classify(docs);
+      if (type == AFTER_OPEN) {
+        translate(docs, frames.back().entity);
+      } else if (type == BEFORE_OPEN) {
+        translate(docs, entity);
       }
-    }
-    if (entity.type != EntityType::NONE) {
+    } else {
+      entity.type = match.type;
+
       /* workaround for entity declaration logic catching punctuation, e.g.
       * ending semicolon in declaration, the equals sign in a variable
       * declaration with initialization, or whitespace */
-      while (middle > start && (in[middle - 1] == ' ' ||
-          in[middle - 1] == '\t' ||
-          in[middle - 1] == '\n' ||
-          in[middle - 1] == '\r' ||
-          in[middle - 1] == '=' ||
-          in[middle - 1] == ';')) {
-        --middle;
+      while (match.middle > match.start && (in[match.middle - 1] == ' ' ||
+          in[match.middle - 1] == '\t' ||
+          in[match.middle - 1] == '\n' ||
+          in[match.middle - 1] == '\r' ||
+          in[match.middle - 1] == '=' ||
+          in[match.middle - 1] == ';')) {
+        --match.middle;
       }
 
-      /* entity declaration */
-      entity.decl = in.substr(start, middle - start);
-
       /* the final node represents the whole entity, pop the stack until we
         * find its direct parent, as determined using nested byte ranges */
-      while (start < starts.back() || ends.back() < end) {
-        Entity back = std::move(entities.back());
-        entities.pop_back();
-        if (back.ingroup.empty()) {
-          entities.back().add(back);
-        } else {
-          entities.front().add(back);
-        }
-        starts.pop_back();
-        ends.pop_back();
+      while (match.start < frames.back().match.start ||
+          frames.back().match.end < match.end) {
+        pop(frames, in);
       }
 
       /* override ingroup for entities that belong to a class or template, as
        * cannot be moved out */
-      if (entities.back().type == EntityType::TYPE ||
-          entities.back().type == EntityType::TEMPLATE) {
+      if (frames.back().entity.type == EntityType::TYPE ||
+          frames.back().entity.type == EntityType::TEMPLATE) {
         entity.ingroup.clear();
       }
 
       /* push to stack */
-      if (entities.back().type == EntityType::TEMPLATE) {
+      if (frames.back().entity.type == EntityType::TEMPLATE) {
         /* merge this entity into the template */
-        entities.back().merge(entity);
+        Frame frame{std::move(entity), match, true};
+        materialize(frames.back(), in);
+        materialize(frame, in);
+        frames.back().entity.merge(std::move(frame.entity));
       } else {
-        entities.emplace_back(std::move(entity));
-        starts.push_back(start);
-        ends.push_back(end);
+        frames.push_back({std::move(entity), match, true});
       }
 
       /* reset */
@@ -151,258 +292,883 @@ void Parser::parse(const std::string& file, Entity& global) {
   }
 
   /* finalize */
-  while (entities.size() > 1) {
-    Entity back = std::move(entities.back());
-    entities.pop_back();
-    if (back.ingroup.empty()) {
-      entities.back().add(back);
-    } else {
-      entities.front().add(back);
+  while (frames.size() > 1) {
+    pop(frames, in);
+  }
+  global = std::move(frames.back().entity);
+  frames.pop_back();
+  assert(frames.empty());
+}
+
+void Parser::pop(std::vector<Frame>& frames, const std::string_view& in) {
+  Frame back = std::move(frames.back());
+  frames.pop_back();
+  if (back.entity.ingroup.empty()) {
+    if (!back.entity.discarded() && !frames.back().entity.discarded()) {
+      materialize(back, in);
+      frames.back().entity.add(std::move(back.entity));
     }
-    starts.pop_back();
-    ends.pop_back();
+  } else if (!back.entity.discarded()) {
+    materialize(back, in);
+    frames.front().entity.add(std::move(back.entity));
   }
-  global = std::move(entities.back());
+}
 
-  entities.pop_back();
-  starts.pop_back();
-  ends.pop_back();
+void Parser::materialize(Frame& frame, const std::string_view& in) {
+  if (frame.lazy) {
+    const Match& match = frame.match;
+    frame.entity.name = in.substr(match.nameStart,
+        match.nameEnd - match.nameStart);
+    frame.entity.decl = in.substr(match.start, match.middle - match.start);
+    frame.lazy = false;
+  }
+}
 
-  assert(entities.empty());
-  assert(starts.empty());
-  assert(ends.empty());
+void Parser::extract(TSNode node, const std::string_view& in,
+    std::vector<Match>& matches) {
+  disagreement = std::numeric_limits<uint32_t>::max();
+  if (extractor == Extractor::WALK) {
+    walker.walk(node, matches);
+  } else if (extractor == Extractor::CHECK) {
+    /* both engines over the whole tree, without a match limit, keeping only
+     * the documentation comments from the walk, as does run() */
+    std::vector<Match> walked;
+    walker.walk(node, walked);
+    std::erase_if(walked, [&](const Match& m) {
+      return m.type == EntityType::NONE &&
+          classify(in.substr(m.start, m.end - m.start)) == NONE;
+    });
+    TSQueryCursor* cursor = ts_query_cursor_new();
+    bool pending = false;
+    run(node, ts_node_start_byte(node), ts_node_end_byte(node), in, cursor,
+        pending, matches);
+    ts_query_cursor_delete(cursor);
+    auto [first, other] = std::mismatch(matches.begin(), matches.end(),
+        walked.begin(), walked.end());
+    if (first != matches.end()) {
+      disagreement = first->start;
+    } else if (other != walked.end()) {
+      disagreement = other->start;
+    }
+  } else {
+    search(node, in, matches);
+  }
+}
+
+void Parser::search(TSNode node, const std::string_view& in,
+    std::vector<Match>& matches) {
+  std::vector<uint32_t> markers;
+  const char* first = in.data();
+  const char* last = first + in.size();
+  while ((first = marker(first, last))) {
+    markers.push_back(first - in.data());
+    ++first;
+  }
 
+  TSQueryCursor* cursor = ts_query_cursor_new();
+  if (matchLimit > 0) {
+    ts_query_cursor_set_match_limit(cursor, matchLimit);
+  }
+  bool pending = false;
+  if (scopes.contains(ts_node_symbol(node))) {
+    scope(node, in, markers, cursor, pending, matches);
+  } else {
+    run(node, ts_node_start_byte(node), ts_node_end_byte(node), in, cursor,
+        pending, matches);
+  }
   ts_query_cursor_delete(cursor);
-  ts_tree_delete(tree);
-  ts_parser_reset(parser);
 }
 
-std::string Parser::preprocess(const std::string& file) {
+void Parser::scope(TSNode node, const std::string_view& in,
+    const std::vector<uint32_t>& markers, TSQueryCursor* cursor,
+    bool& pending, std::vector<Match>& matches) {
+  TSTreeCursor children = ts_tree_cursor_new(node);
+  TSNode skipped{};  // last child skipped, if immediately preceding
+  if (ts_tree_cursor_goto_first_child(&children)) do {
+    TSNode child = ts_tree_cursor_current_node(&children);
+    TSSymbol symbol = ts_node_symbol(child);
+    uint32_t k = ts_node_start_byte(child);
+    uint32_t l = ts_node_end_byte(child);
+    if (comments.contains(symbol)) {
+      /* matched here rather than by the query, as the query would */
+      int type = classify(in.substr(k, l - k));
+      if (type == AFTER_OPEN && !ts_node_is_null(skipped)) {
+        /* documents the entity before it, so that cannot be skipped */
+        run(skipped, ts_node_start_byte(skipped), ts_node_end_byte(skipped),
+            in, cursor, pending, matches);
+      } else if (type == BEFORE_OPEN) {
+        pending = true;
+      }
+      if (type != NONE) {
+        matches.push_back({EntityType::NONE, k, l, l, k, k});
+      }
+      skipped = TSNode{};
+    } else if (namespaces.contains(symbol)) {
+      /* query the head only, up to and including the opening brace of the
+       * body, then treat the body as a scope */
+      TSNode body = ts_node_child_by_field_name(child, "body", 4);
+      if (ts_node_is_null(body)) {
+        run(child, k, l, in, cursor, pending, matches);
+      } else {
+        run(child, k, ts_node_start_byte(body) + 1, in, cursor, pending,
+            matches);
+        scope(body, in, markers, cursor, pending, matches);
+      }
+      skipped = TSNode{};
+    } else if (scopes.contains(symbol)) {
+      scope(child, in, markers, cursor, pending, matches);
+      skipped = TSNode{};
+    } else if (ts_node_is_named(child)) {
+      auto iter = std::lower_bound(markers.begin(), markers.end(), k);
+      if (pending || (iter != markers.end() && *iter < l)) {
+        run(child, k, l, in, cursor, pending, matches);
+        skipped = TSNode{};
+      } else {
+        skipped = child;
+      }
+    }
+  } while (ts_tree_cursor_goto_next_sibling(&children));
+  ts_tree_cursor_delete(&children);
+}
+
+void Parser::run(TSNode node, const uint32_t start, const uint32_t end,
+    const std::string_view& in, TSQueryCursor* cursor, bool& pending,
+    std::vector<Match>& matches) {
+  size_t first = matches.size();
+  auto exec = [&]() {
+    ts_query_cursor_exec(cursor, query.get(), node);
+    TSQueryMatch match;
+    while (ts_query_cursor_next_match(cursor, &match)) {
+      Match m{EntityType::NONE, 0, 0, 0, 0, 0};
+      bool docs = false;
+      for (uint16_t i = 0; i < match.capture_count; ++i) {
+        TSNode capture = match.captures[i].node;
+        uint32_t id = match.captures[i].index;
+        uint32_t k = ts_node_start_byte(capture);
+        uint32_t l = ts_node_end_byte(capture);
+
+        switch (captures[id]) {
+        case Capture::DOCS:
+          docs = true;
+          m.start = k;
+          m.middle = l;
+          m.end = l;
+          break;
+        case Capture::NAME:
+          m.nameStart = k;
+          m.nameEnd = l;
+          break;
+        case Capture::BODY:
+        case Capture::VALUE:
+          m.middle = k;
+          break;
+        case Capture::ENTITY:
+          m.start = k;
+          m.end = l;
+          m.middle = l;
+          if (types[id] != EntityType::NONE) {
+            m.type = types[id];
+          }
+          break;
+        }
+      }
+      /* comments other than documentation comments are dropped here, as
+       * the C API does not evaluate query predicates that could */
+      if ((docs && classify(in.substr(m.start, m.end - m.start)) != NONE) ||
+          m.type != EntityType::NONE) {
+        matches.push_back(m);
+      }
+    }
+  };
+  ts_query_cursor_set_byte_range(cursor, start, end);
+  exec();
+  if (ts_query_cursor_did_exceed_match_limit(cursor)) {
+    /* in-progress matches may have been dropped, so run again, once, over
+     * the same range without limit */
+    exceeded = true;
+    matches.resize(first);
+    ts_query_cursor_set_match_limit(cursor,
+        std::numeric_limits<uint32_t>::max());
+    exec();
+    if (matchLimit > 0) {
+      ts_query_cursor_set_match_limit(cursor, matchLimit);
+    }
+  }
+
+  /* documentation comments are attached to the next entity, so one may
+   * still be pending after the last entity matched */
+  for (size_t i = matches.size(); i > first; --i) {
+    const Match& m = matches[i - 1];
+    if (m.type != EntityType::NONE) {
+      pending = false;
+      break;
+    } else if (classify(in.substr(m.start, m.end - m.start)) ==
+        BEFORE_OPEN) {
+      pending = true;
+      break;
+    }
+  }
+}
+
+std::vector<std::string> Parser::references(const std::string& source) const {
+  std::set<std::string> names;
+  for (auto& use : scan(source)) {
+    names.emplace(use);
+  }
+  return std::vector<std::string>(names.begin(), names.end());
+}
+
+bool Parser::documented(const std::string_view& source) {
+  return marker(source.data(), source.data() + source.size()) != nullptr;
+}
+
+const char* Parser::marker(const char* first, const char* last) {
+  /* look for the opening marker of a documentation comment, jumping from
+   * slash to slash with memchr() */
+  while ((first = (const char*)std::memchr(first, '/', last - first))) {
+    if (last - first >= 3 && (first[1] == '*' || first[1] == '/') &&
+        (first[2] == first[1] || first[2] == '!')) {
+      return first;
+    }
+    ++first;
+  }
+  return nullptr;
+}
+
+int Parser::classify(const std::string_view& comment) {
+  /* as for the first token of Tokenizer::next(), but without tokenizing */
+  if (comment.size() >= 3 && comment[0] == '/' &&
+      ((comment[1] == '*' && (comment[2] == '*' || comment[2] == '!')) ||
+      (comment[1] == '/' && (comment[2] == '/' || comment[2] == '!')))) {
+    return comment.size() >= 4 && comment[3] == '<' ? AFTER_OPEN :
+        BEFORE_OPEN;
+  }
+  return NONE;
+}
+
+void Parser::coalesce(const std::string_view& in,
+    std::vector<Match>& matches) {
+  auto line = [&](const Match& m) {
+    std::string_view comment = in.substr(m.start, m.end - m.start);
+    return m.type == EntityType::NONE && comment.starts_with("//") ?
+        classify(comment) : NONE;
+  };
+  size_t n = 0;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    int type = line(matches[i]);
+    if (type != NONE && n > 0 && line(matches[n - 1]) == type &&
+        in.find_first_not_of(" \t\r\n", matches[n - 1].end) ==
+        matches[i].start) {
+      Match& m = matches[n - 1];
+      m.end = matches[i].end;
+      m.middle = m.end;
+      m.nameStart = m.start;
+      m.nameEnd = m.start;
+    } else {
+      matches[n++] = matches[i];
+    }
+  }
+  matches.resize(n);
+}
+
+std::vector<std::string_view> Parser::scan(const std::string_view& source)
+    const {
+  std::vector<std::string_view> uses;
+  size_t i = 0, n = source.size();
+  while (i < n) {
+    unsigned char c = source[i];
+    if (std::isalpha(c) || c == '_') {
+      /* identifier */
+      size_t j = i + 1;
+      while (j < n && (std::isalnum((unsigned char)source[j]) ||
+          source[j] == '_')) {
+        ++j;
+      }
+      std::string_view name = source.substr(i, j - i);
+      if (isDefine(name)) {
+        uses.push_back(name);
+      }
+      i = j;
+    } else if (std::isdigit(c)) {
+      /* number, skip so that e.g. suffixes are not taken as identifiers */
+      while (i < n && (std::isalnum((unsigned char)source[i]) ||
+          source[i] == '_' || source[i] == '.')) {
+        ++i;
+      }
+    } else {
+      ++i;
+    }
+  }
+  return uses;
+}
+
+TSTree* Parser::preprocess(const std::string& file, const std::string& source,
+    std::string& in, const int offset) {
   static std::regex macro(R"([A-Z_][A-Z0-9_]{2,})");
 
-  std::string in = gulp(file);
-  TSTree* tree = ts_parser_parse_string(parser, NULL, in.data(), in.size());
+  TSTree* tree = reparse(nullptr, source);
+  if (!tree) {
+    warn("parse time budget of " << timeBudget << " ms exceeded in " <<
+        file << " after " << elapsed() << " ms, skipping");
+    return nullptr;
+  }
   TSNode root = ts_tree_root_node(tree);
   TSNode node = root;
   TSTreeCursor cursor = ts_tree_cursor_new(root);
-  do {
+
+  /* find all uses of preprocessor macros in a single pass; only subtrees
+   * that contain the name of a define, according to scan(), are visited, and
+   * not preprocessor definitions, as we do not want to replace preprocessor
+   * macros there */
+  std::vector<uint32_t> offsets;
+  for (auto& use : scan(source)) {
+    offsets.push_back(use.data() - source.data());
+  }
+  std::vector<std::pair<uint32_t,uint32_t>> uses;
+  uint32_t covered = 0;  // end of the last use, as uses may not overlap
+  if (!offsets.empty()) do {
     uint32_t k = ts_node_start_byte(node);
     uint32_t l = ts_node_end_byte(node);
-    TSPoint from = ts_node_start_point(node);
-    TSPoint to = ts_node_end_point(node);
-    bool nextNodeChosen = false;
-
-    if (defines.contains(in.substr(k, l - k))) {
-      /* replace preprocessor macro */
-      std::string& value = defines.at(in.substr(k, l - k));
-      uint32_t old_size = in.size();
-      in.replace(k, l - k, value);
-      uint32_t new_size = in.size();
-      TSPoint root_to = ts_node_end_point(root);
-
-      /* update tree */
-      TSInputEdit edit{k, old_size, new_size, from, root_to, root_to};
-      ts_tree_edit(tree, &edit);
-      ts_parser_reset(parser);
-      TSTree* old_tree = tree;
-      tree = ts_parser_parse_string(parser, old_tree, in.data(), in.size());
-      ts_tree_delete(old_tree);
-      root = ts_tree_root_node(tree);
+    TSSymbol symbol = ts_node_symbol(node);
+    auto offset = std::lower_bound(offsets.begin(), offsets.end(), k);
+    bool descend = false;
+    if (offset != offsets.end() && *offset < l) {
+      if (identifiers.contains(symbol)) {
+        std::string_view name = std::string_view(source).substr(k, l - k);
+        if (k >= covered && isDefine(name)) {
+          if (!defines.find(name)->second.function) {
+            uses.push_back({k, l});
+            covered = l;
+          } else {
+            /* a use of a function-like define extends to the end of its
+             * arguments, and is only a use if it has them */
+            std::vector<std::string_view> args;
+            size_t end = invocation(source, l, args);
+            if (end != std::string::npos) {
+              uses.push_back({k, uint32_t(end)});
+              covered = end;
+            }
+          }
+        }
+      } else {
+        descend = !definitions.contains(symbol);
+      }
+    }
+    next(cursor, descend);
+    node = ts_tree_cursor_current_node(&cursor);
+  } while (!ts_node_eq(node, root));
+
+  /* replace them all, then reparse once */
+  SourceMap map;
+  if (uses.empty()) {
+    in = source;
+  } else {
+    in.clear();
+    in.reserve(source.size());
+    uint32_t prev = 0;
+    for (auto [k, l] : uses) {
+      in.append(source, prev, k - prev);
+      uint32_t first = in.size();
+      std::set<std::string> active;
+      expand(std::string_view(source).substr(k, l - k), in, active);
+      map.replace(k, l, first, in.size());
+      prev = l;
+    }
+    in.append(source, prev);
 
-      /* restore cursor to same position as edit */
+    ts_parser_reset(parser);
+    TSTree* new_tree = reparse(nullptr, in);
+    if (new_tree) {
+      ts_tree_delete(tree);
+      tree = new_tree;
+      root = ts_tree_root_node(tree);
+      node = root;
       ts_tree_cursor_reset(&cursor, root);
-      while (ts_tree_cursor_goto_first_child_for_byte(&cursor, k) >= 0);
-
-      /* next iteration from this position */
-      nextNodeChosen = true;
-    } else if (ts_node_is_error(node)) {
-      /* parse error: assuming that the syntax is actually valid, this is
-       * usually caused by use of preprocessor macros, as the preprocessor is
-       * not run */
-      std::cerr << file << ':' << (from.row + 1) << ':' << from.column <<
-          ": warning: parse failed at '" << in.substr(k, l - k) << "'" <<
-          std::endl;
-
-      /* attempt recovery: step backward looking for a node that looks like
-       * preprocessor macro use, and erase it */
-      int back = 0;
-      while (!std::regex_match(in.substr(k, l - k), macro) &&
-          ts_tree_cursor_goto_previous_sibling(&cursor)) {
-        node = ts_tree_cursor_current_node(&cursor);
-        k = ts_node_start_byte(node);
-        l = ts_node_end_byte(node);
-        from = ts_node_start_point(node);
-        to = ts_node_end_point(node);
-        ++back;
-      }
-      if (std::regex_match(in.substr(k, l - k), macro)) {
-        /* looks like a macro, erase it */
-        std::cerr << file << ':' << (from.row + 1) << ':' << from.column <<
-            ": note: attempting recovery by erasing '" <<
-            in.substr(k, l - k) << "'" << std::endl;
-
-        /* overwrite with whitespace, rather than erasing entirely, to
-         * preserve line and column numbers from user's perspective */
-        uint32_t old_size = in.size();
-        in.replace(k, l - k, l - k, ' ');
-        uint32_t new_size = in.size();
-        TSPoint root_to = ts_node_end_point(root);
-
-        /* update tree */
-        TSInputEdit edit{k, old_size, new_size, from, root_to, root_to};
-        ts_tree_edit(tree, &edit);
-        ts_parser_reset(parser);
-        TSTree* old_tree = tree;
-        tree = ts_parser_parse_string(parser, old_tree, in.data(), in.size());
-        ts_tree_delete(old_tree);
-        root = ts_tree_root_node(tree);
-
-        /* restore cursor to same byte position as edit */
-        ts_tree_cursor_reset(&cursor, root);
-        while (ts_tree_cursor_goto_first_child_for_byte(&cursor, k) >= 0);
-
-        /* next iteration from this position */
-        nextNodeChosen = true;
-      } else {
-        /* recovery failed, restore original position */
-        warn("recovery failed, continuing anyway");
-        while (back--) {
-          ts_tree_cursor_goto_next_sibling(&cursor);
+    } else {
+      warn("parse time budget of " << timeBudget << " ms exceeded in " <<
+          file << " after " << elapsed() <<
+          " ms, continuing without replacing defines");
+      in = source;
+      map = SourceMap();
+    }
+  }
+
+  /* recover from parse errors: assuming that the syntax is actually valid,
+   * these are usually caused by use of preprocessor macros, as the
+   * preprocessor is not run; each round finds a candidate macro for every
+   * error, erases them all, then reparses once; as edits preserve byte
+   * offsets, an error that persists across rounds is reported only once,
+   * and is only reported as unrecovered once the last round gives up */
+  std::unordered_set<uint32_t> reported;  // start bytes of errors reported
+  std::vector<uint32_t> failed;  // start bytes of errors without recovery
+  for (int round = 0; !timedOut && ts_node_has_error(root); ++round) {
+    std::vector<TSInputEdit> edits;
+    failed.clear();
+    node = root;
+    ts_tree_cursor_reset(&cursor, root);
+    do {
+      if (ts_node_is_error(node)) {
+        uint32_t k = ts_node_start_byte(node);
+        uint32_t l = ts_node_end_byte(node);
+        TSPoint at = map.point(source, k);
+        if (round == 0) {
+          ++stats.errors;
+        }
+        if (reported.insert(k).second) {
+          std::cerr << file << ':' << (int(at.row) + 1 + offset) << ':' <<
+              at.column << ": warning: parse failed at '" <<
+              in.substr(k, l - k) << "'" << std::endl;
+        }
+
+        /* step backward looking for a node that looks like preprocessor
+         * macro use */
+        TSNode prev = node;
+        while (!ts_node_is_null(prev) && !std::regex_match(
+            in.substr(ts_node_start_byte(prev), ts_node_end_byte(prev) -
+            ts_node_start_byte(prev)), macro)) {
+          prev = ts_node_prev_sibling(prev);
+        }
+        if (round < maxRecoveryRounds && !ts_node_is_null(prev)) {
+          k = ts_node_start_byte(prev);
+          l = ts_node_end_byte(prev);
+          bool seen = std::any_of(edits.begin(), edits.end(),
+              [k](const TSInputEdit& edit) {
+                return edit.start_byte == k;
+              });
+          if (!seen) {
+            at = map.point(source, k);
+            std::cerr << file << ':' << (int(at.row) + 1 + offset) << ':' <<
+                at.column << ": note: attempting recovery by erasing '" <<
+                in.substr(k, l - k) << "'" << std::endl;
+            edits.push_back({k, l, l, ts_node_start_point(prev),
+                ts_node_end_point(prev), ts_node_end_point(prev)});
+          }
+        } else {
+          failed.push_back(k);
         }
       }
+      next(cursor, ts_node_has_error(node));
+      node = ts_tree_cursor_current_node(&cursor);
+    } while (!ts_node_eq(node, root));
+
+    if (edits.empty()) {
+      break;
     }
 
-    /* next node */
-    if (!nextNodeChosen) {
-      if (strcmp(ts_node_type(node), "preproc_def") != 0 &&
-          strcmp(ts_node_type(node), "preproc_function_def") != 0 &&
-          ts_tree_cursor_goto_first_child(&cursor)) {
-        // ^ don't recurse into preprocessor definitions, as we do not want to
-        //   replace preprocessor macros there
-      } else if (ts_tree_cursor_goto_next_sibling(&cursor)) {
-        //
-      } else while (ts_tree_cursor_goto_parent(&cursor) &&
-          !ts_tree_cursor_goto_next_sibling(&cursor)) {
-        //
+    /* overwrite with whitespace, rather than erasing entirely, to preserve
+     * line and column numbers from user's perspective, then reparse; the
+     * erased text is kept in case the reparse runs out of time */
+    std::vector<std::string> erased;
+    for (auto& edit : edits) {
+      uint32_t k = edit.start_byte;
+      uint32_t l = edit.old_end_byte;
+      erased.push_back(in.substr(k, l - k));
+      in.replace(k, l - k, l - k, ' ');
+      ts_tree_edit(tree, &edit);
+    }
+    ts_parser_reset(parser);
+    TSTree* new_tree = reparse(tree, in);
+    if (!new_tree) {
+      /* edits do not change sizes, so the edited tree still fits the
+       * restored source */
+      for (size_t i = 0; i < edits.size(); ++i) {
+        in.replace(edits[i].start_byte, erased[i].size(), erased[i]);
       }
+      warn("parse time budget of " << timeBudget << " ms exceeded in " <<
+          file << " after " << elapsed() <<
+          " ms, continuing without further error recovery");
+      break;
     }
-    node = ts_tree_cursor_current_node(&cursor);
-  } while (!ts_node_eq(node, root));
+    ts_tree_delete(tree);
+    tree = new_tree;
+    root = ts_tree_root_node(tree);
+    stats.erasures += edits.size();
+    stats.reparses += 1;
+    failed.clear();
+  }
+  for (uint32_t k : failed) {
+    TSPoint at = map.point(source, k);
+    std::cerr << file << ':' << (int(at.row) + 1 + offset) << ':' <<
+        at.column << ": warning: recovery failed, continuing anyway" <<
+        std::endl;
+  }
 
   ts_tree_cursor_delete(&cursor);
-  ts_tree_delete(tree);
   ts_parser_reset(parser);
-  return in;
+  return tree;
+}
+
+TSTree* Parser::reparse(const TSTree* old, const std::string& in) {
+  uint64_t timeout = 0;
+  if (timeBudget > 0) {
+    uint64_t used = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    if (used >= timeBudget*1000) {
+      timedOut = true;
+      return nullptr;
+    }
+    timeout = timeBudget*1000 - used;
+  }
+  ts_parser_set_timeout_micros(parser, timeout);
+  TSTree* tree = ts_parser_parse_string(parser, old, in.data(), in.size());
+  if (!tree) {
+    /* the parser keeps its state to resume, which is not wanted */
+    timedOut = timeBudget > 0;
+    ts_parser_reset(parser);
+  }
+  return tree;
+}
+
+uint64_t Parser::elapsed() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started).count();
+}
+
+void Parser::expand(const std::string_view& text, std::string& out,
+    std::set<std::string>& active) {
+  /* as for the C preprocessor, macros are expanded recursively, but not
+   * within their own expansion */
+  size_t i = 0, n = text.size();
+  while (i < n) {
+    unsigned char c = text[i];
+    if (std::isalpha(c) || c == '_') {
+      size_t j = i + 1;
+      while (j < n && (std::isalnum((unsigned char)text[j]) ||
+          text[j] == '_')) {
+        ++j;
+      }
+      std::string id(text.substr(i, j - i));
+      auto iter = defines.find(id);
+      std::vector<std::string_view> args;
+      std::string body;
+      if (iter == defines.end() || active.contains(id)) {
+        out.append(id);
+      } else if (!iter->second.function) {
+        active.insert(id);
+        expand(iter->second.value, out, active);
+        active.erase(id);
+      } else if (size_t k = invocation(text, j, args);
+          k != std::string::npos &&
+          substitute(iter->second, args, active, body)) {
+        ++stats.expansions;
+        active.insert(id);
+        expand(body, out, active);
+        active.erase(id);
+        j = k;
+      } else {
+        /* without arguments, or the wrong number, not a use */
+        out.append(id);
+      }
+      i = j;
+    } else if (c == '"' || c == '\'') {
+      /* string or character literal, copy as is */
+      size_t j = literal(text, i);
+      out.append(text, i, j - i);
+      i = j;
+    } else {
+      out.push_back(c);
+      ++i;
+    }
+  }
+}
+
+bool Parser::substitute(const Define& define,
+    std::vector<std::string_view> args, std::set<std::string>& active,
+    std::string& out) {
+  const std::string& value = define.value;
+  bool variadic = !define.params.empty() && define.params.back() == "...";
+  size_t named = define.params.size() - (variadic ? 1 : 0);
+  if (named == 0 && args.size() == 1 && args.front().empty()) {
+    args.clear();
+  }
+  if (args.size() < named || (!variadic && args.size() > named)) {
+    return false;
+  }
+
+  /* arguments are fully expanded before substitution, except as operands
+   * of # and ## */
+  std::vector<std::string> expanded(args.size());
+  for (size_t a = 0; a < args.size(); ++a) {
+    expand(args[a], expanded[a], active);
+  }
+  auto argument = [&](const std::string_view& id, const bool raw,
+      std::string& to) {
+    auto param = std::find(define.params.begin(), define.params.begin() +
+        named, id);
+    size_t first, last;
+    if (param != define.params.begin() + named) {
+      first = param - define.params.begin();
+      last = first + 1;
+    } else if (variadic && id == "__VA_ARGS__") {
+      first = named;
+      last = args.size();
+    } else {
+      return false;
+    }
+    for (size_t a = first; a < last; ++a) {
+      if (a > first) {
+        to.append(", ");
+      }
+      if (raw) {
+        to.append(args[a]);
+      } else {
+        to.append(expanded[a]);
+      }
+    }
+    return true;
+  };
+  auto paste = [&](const size_t from) {
+    size_t k = value.find_first_not_of(" \t", from);
+    return k != std::string::npos && value.compare(k, 2, "##") == 0;
+  };
+
+  size_t i = 0, n = value.size();
+  bool pasted = false;  // just after ##?
+  while (i < n) {
+    unsigned char c = value[i];
+    if (std::isalpha(c) || c == '_') {
+      size_t j = i + 1;
+      while (j < n && (std::isalnum((unsigned char)value[j]) ||
+          value[j] == '_')) {
+        ++j;
+      }
+      std::string_view id = std::string_view(value).substr(i, j - i);
+      if (!argument(id, pasted || paste(j), out)) {
+        out.append(id);
+      }
+      pasted = false;
+      i = j;
+    } else if (c == '#' && i + 1 < n && value[i + 1] == '#') {
+      /* token pasting, join the tokens either side */
+      while (!out.empty() && (out.back() == ' ' || out.back() == '\t')) {
+        out.pop_back();
+      }
+      i = value.find_first_not_of(" \t", i + 2);
+      i = (i == std::string::npos) ? n : i;
+      pasted = true;
+    } else if (c == '#') {
+      /* stringification, if followed by a parameter */
+      size_t j = value.find_first_not_of(" \t", i + 1);
+      size_t k = j;
+      while (k < n && (std::isalnum((unsigned char)value[k]) ||
+          value[k] == '_')) {
+        ++k;
+      }
+      std::string arg;
+      if (j != std::string::npos && k > j &&
+          argument(std::string_view(value).substr(j, k - j), true, arg)) {
+        out.push_back('"');
+        for (char d : arg) {
+          if (d == '"' || d == '\\') {
+            out.push_back('\\');
+          }
+          out.push_back(d);
+        }
+        out.push_back('"');
+        i = k;
+      } else {
+        out.push_back(c);
+        ++i;
+      }
+      pasted = false;
+    } else if (c == '"' || c == '\'') {
+      /* string or character literal, copy as is */
+      size_t j = literal(value, i);
+      out.append(value, i, j - i);
+      pasted = false;
+      i = j;
+    } else {
+      out.push_back(c);
+      pasted = pasted && (c == ' ' || c == '\t');
+      ++i;
+    }
+  }
+  return true;
+}
+
+size_t Parser::invocation(const std::string_view& text, const size_t from,
+    std::vector<std::string_view>& args) {
+  size_t i = text.find_first_not_of(" \t\r\n", from);
+  if (i == std::string_view::npos || text[i] != '(') {
+    return std::string_view::npos;
+  }
+  auto trim = [&](const size_t first, const size_t last) {
+    std::string_view arg = text.substr(first, last - first);
+    size_t k = arg.find_first_not_of(" \t\r\n");
+    if (k == std::string_view::npos) {
+      return std::string_view();
+    }
+    return arg.substr(k, arg.find_last_not_of(" \t\r\n") + 1 - k);
+  };
+  size_t first = ++i, n = text.size();
+  int depth = 0;
+  while (i < n) {
+    char c = text[i];
+    if (c == '"' || c == '\'') {
+      i = literal(text, i);
+    } else {
+      if (c == '(') {
+        ++depth;
+      } else if (c == ')' && depth > 0) {
+        --depth;
+      } else if (c == ')' || (c == ',' && depth == 0)) {
+        args.push_back(trim(first, i));
+        first = i + 1;
+        if (c == ')') {
+          return i + 1;
+        }
+      } else if ((c == ';' || c == '}') && depth == 0) {
+        /* cannot be within the arguments, so unbalanced; stop here rather
+         * than scan to the end */
+        break;
+      }
+      ++i;
+    }
+  }
+  args.clear();
+  return std::string_view::npos;
+}
+
+size_t Parser::literal(const std::string_view& text, const size_t from) {
+  char c = text[from];
+  size_t j = from + 1, n = text.size();
+  while (j < n && text[j] != c) {
+    j += (text[j] == '\\') ? 2 : 1;
+  }
+  return std::min(j + 1, n);
+}
+
+bool Parser::isDefine(const std::string_view& str) const {
+  return minLength <= str.size() && str.size() <= maxLength &&
+      initials.test((unsigned char)str.front()) && defines.contains(str);
+}
+
+void Parser::next(TSTreeCursor& cursor, const bool descend) {
+  if (descend && ts_tree_cursor_goto_first_child(&cursor)) {
+    //
+  } else if (ts_tree_cursor_goto_next_sibling(&cursor)) {
+    //
+  } else while (ts_tree_cursor_goto_parent(&cursor) &&
+      !ts_tree_cursor_goto_next_sibling(&cursor)) {
+    //
+  }
 }
 
 void Parser::translate(const std::string_view& comment, Entity& entity) {
   int indent = 0;
   bool file = false;  // does this contain @file?
-  Tokenizer tokenizer(comment);
+  Tokenizer tokenizer(comment, comment.starts_with("//"));
   Token token = tokenizer.next();
   token = tokenizer.next();
   while (token.type) {
     if (token.type & COMMAND) {
-      /* non-legacy commands */
-      if (token.substr(1) == "param" ||
-          token.substr(1) == "param[in]") {
+      /* built-in commands are found with a perfect hash; aliases and custom
+       * commands only on a miss, so that they cost nothing otherwise */
+      std::string_view name = token.substr(1);
+      Command cmd = command(name);
+      if (cmd == Command::NONE) {
+        if (auto alias = aliases.find(name); alias != aliases.end()) {
+          name = alias->second;
+          cmd = command(name);
+        }
+      }
+      switch (cmd) {
+      case Command::PARAM:
         entity.docs.append(":material-location-enter: **Parameter** `");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("`\n:   ");
         indent = 4;
-      } else if (token.substr(1) == "param[out]") {
+        break;
+      case Command::PARAM_OUT:
         entity.docs.append(":material-location-exit: **Parameter** `");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("`\n:   ");
         indent = 4;
-      } else if (token.substr(1) == "param[in,out]") {
+        break;
+      case Command::PARAM_IN_OUT:
         entity.docs.append(":material-location-enter::material-location-exit: **Parameter** `");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("`\n:   ");
         indent = 4;
-      } else if (token.substr(1) == "tparam") {
+        break;
+      case Command::TPARAM:
         entity.docs.append(":material-code-tags: **Template parameter** `");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("`\n:   ");
         indent = 4;
-      } else if (token.substr(1) == "p") {
+        break;
+      case Command::CODE:
         entity.docs.append("`");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("`");
-      } else if (token.substr(1) == "return") {
+        break;
+      case Command::RETURN:
         entity.docs.append(":material-keyboard-return: **Return**\n:   ");
-      } else if (token.substr(1) == "pre") {
+        break;
+      case Command::PRE:
         entity.docs.append(":material-check-circle-outline: **Pre-condition**\n:   ");
-      } else if (token.substr(1) == "post") {
+        break;
+      case Command::POST:
         entity.docs.append(":material-check-circle-outline: **Post-condition**\n:   ");
-      } else if (token.substr(1) == "throw") {
+        break;
+      case Command::THROW:
         entity.docs.append(":material-alert-circle-outline: **Throw**\n:   ");
-      } else if (token.substr(1) == "see") {
+        break;
+      case Command::SEE:
         entity.docs.append(":material-eye-outline: **See**\n:   ");
-      } else if (token.substr(1) == "anchor") {
+        break;
+      case Command::ANCHOR:
         entity.docs.append("<a name=\"");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("\"></a>");
-      } else if (token.substr(1) == "note" ||
-          token.substr(1) == "abstract" ||
-          token.substr(1) == "info" ||
-          token.substr(1) == "tip" ||
-          token.substr(1) == "success" ||
-          token.substr(1) == "question" ||
-          token.substr(1) == "warning" ||
-          token.substr(1) == "failure" ||
-          token.substr(1) == "danger" ||
-          token.substr(1) == "bug" ||
-          token.substr(1) == "example" ||
-          token.substr(1) == "quote") {
+        break;
+      case Command::ADMONITION:
         entity.docs.append("!!! ");
-        entity.docs.append(token.substr(1));
+        entity.docs.append(name);
         entity.docs.append("\n");
         indent += 4;
         entity.docs.append(indent, ' ');
-      } else if (token.substr(1) == "ingroup") {
+        break;
+      case Command::INGROUP:
         entity.ingroup = tokenizer.consume(WORD).str();
-
-      /* legacy commands */
-      } else if (token.substr(1) == "returns" ||
-          token.substr(1) == "result") {
+        break;
+      case Command::RETURNS:
         entity.docs.append(":material-location-exit: **Return**\n:   ");
-      } else if (token.substr(1) == "sa") {
-        entity.docs.append(":material-eye-outline: **See**\n:   ");
-      } else if (token.substr(1) == "file") {
+        break;
+      case Command::FILE:
         file = true;
-      } else if (token.substr(1) == "internal") {
+        break;
+      case Command::INTERNAL:
         entity.hide = true;
-      } else if (token.substr(1) == "brief" ||
-          token.substr(1) == "short") {
+        break;
+      case Command::BRIEF: {
         auto first = tokenizer.consume(~WHITESPACE);
         auto last = tokenizer.consume(PARA|CLOSE);
         entity.brief.append(first.first, last.first);
         entity.docs.append(first.first, last.first);
         entity.docs.append("\n\n");
-      } else if (token.substr(1) == "e" ||
-          token.substr(1) == "em" ||
-          token.substr(1) == "a") {
+        break;
+      }
+      case Command::EMPHASIS:
         entity.docs.append("*");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("*");
-      } else if (token.substr(1) == "b") {
+        break;
+      case Command::BOLD:
         entity.docs.append("**");
         entity.docs.append(tokenizer.consume(WORD).str());
         entity.docs.append("**");
-      } else if (token.substr(1) == "c") {
-        entity.docs.append("`");
-        entity.docs.append(tokenizer.consume(WORD).str());
-        entity.docs.append("`");
-      } else if (token.substr(1) == "f$") {
+        break;
+      case Command::MATH_INLINE:
         entity.docs.append("$");
-      } else if (token.substr(1) == "f[" ||
-          token.substr(1) == "f]") {
+        break;
+      case Command::MATH_BLOCK:
         entity.docs.append("$$");
-      } else if (token.substr(1) == "li" ||
-          token.substr(1) == "arg") {
+        break;
+      case Command::ITEM:
         entity.docs.append("  - ");
-      } else if (token.substr(1) == "ref") {
+        break;
+      case Command::REF: {
         auto href = tokenizer.consume(WORD);
         auto text = tokenizer.consume(WORD);
         entity.docs.append("[");
@@ -410,48 +1176,50 @@ void Parser::translate(const std::string_view& comment, Entity& entity) {
         entity.docs.append("](#");
         entity.docs.append(href.str());
         entity.docs.append(")");
-      } else if (token.substr(1) == "code" ||
-          token.substr(1) == "endcode" ||
-          token.substr(1) == "verbatim" ||
-          token.substr(1) == "endverbatim") {
+        break;
+      }
+      case Command::FENCE:
         entity.docs.append("```");
-      } else if (token.substr(1) == "attention") {
+        break;
+      case Command::ATTENTION:
         entity.docs.append("!!! warning \"Attention\"\n");
         indent += 4;
         entity.docs.append(indent, ' ');
-      } else if (token.substr(1) == "todo") {
+        break;
+      case Command::TODO:
         entity.docs.append("!!! example \"To-do\"\n");
         indent += 4;
         entity.docs.append(indent, ' ');
-      } else if (token.substr(1) == "remark") {
+        break;
+      case Command::REMARK:
         entity.docs.append("!!! quote \"Remark\"\n");
         indent += 4;
         entity.docs.append(indent, ' ');
-      } else if (token.substr(1) == "def" ||
-          token.substr(1) == "var" ||
-          token.substr(1) == "fn" ||
-          token.substr(1) == "class" ||
-          token.substr(1) == "struct" ||
-          token.substr(1) == "union" ||
-          token.substr(1) == "enum" ||
-          token.substr(1) == "typedef" ||
-          token.substr(1) == "namespace" ||
-          token.substr(1) == "interface" ||
-          token.substr(1) == "protocol" ||
-          token.substr(1) == "property") {
+        break;
+      case Command::IGNORE:
         /* ignore, including following name */
         tokenizer.consume(WORD);
-      } else if (token.substr(1) == "@") {
+        break;
+      case Command::AT:
         entity.docs.append("@");
-      } else if (token.substr(1) == "/") {
+        break;
+      case Command::SLASH:
         entity.docs.append("/");
-      } else if (token.str().at(0) == '\\') {
-        /* unrecognized command starting with legacy backslash, could just
-          * be e.g. a LaTeX macro, output as is */
-        entity.docs.append(token.str());
-      } else {
-        warn("unrecognized command: " << token.str());
-        entity.docs.append(token.str());
+        break;
+      case Command::NONE:
+        if (auto custom = commands.find(name); custom != commands.end()) {
+          entity.docs.append(custom->second);
+        } else if (token.str().at(0) == '\\') {
+          /* unrecognized command starting with legacy backslash, could just
+            * be e.g. a LaTeX macro, output as is */
+          entity.docs.append(token.str());
+        } else {
+          if (!quiet) {
+            warn("unrecognized command: " << token.str());
+          }
+          entity.docs.append(token.str());
+        }
+        break;
       }
     } else if (token.type & PARA) {
       entity.docs.append("\n\n");
@@ -2,6 +2,93 @@
 
 #include "doxide.hpp"
 #include "Entity.hpp"
+#include "Define.hpp"
+#include "Match.hpp"
+#include "Walker.hpp"
+#include "Arena.hpp"
+
+/**
+ * Kinds of capture in the C++ query. A capture of kind `ENTITY` is of the
+ * whole entity, while `BODY` and `VALUE` mark where its declaration ends.
+ */
+enum class Capture {
+  DOCS,
+  NAME,
+  BODY,
+  VALUE,
+  ENTITY
+};
+
+/**
+ * Extraction engines, which find entities and documentation comments in a
+ * parse tree. Both give the same documentation. `CHECK` runs both, and uses
+ * the result of the query, to check that they agree; it also checks that the
+ * query gives the same entities with and without the pruning of parts of the
+ * tree that cannot be documented, which `QUERY` does.
+ */
+enum class Extractor {
+  QUERY,
+  WALK,
+  CHECK
+};
+
+/**
+ * Parser statistics, for the build summary.
+ */
+struct ParserStats {
+  /**
+   * Constructor.
+   */
+  ParserStats();
+
+  /**
+   * Accumulate statistics.
+   */
+  ParserStats& operator+=(const ParserStats& o);
+
+  /**
+   * Number of files parsed.
+   */
+  int files;
+
+  /**
+   * Number of uses of function-like defines expanded, including uses within
+   * the arguments and replacements of others.
+   */
+  int expansions;
+
+  /**
+   * Number of parse errors remaining after defines are replaced, before
+   * error recovery.
+   */
+  int errors;
+
+  /**
+   * Number of macro uses erased by error recovery.
+   */
+  int erasures;
+
+  /**
+   * Number of reparses made by error recovery.
+   */
+  int reparses;
+
+  /**
+   * Number of files for which the query exceeded its match limit.
+   */
+  int overflows;
+
+  /**
+   * Number of files for which the parse exceeded its time budget.
+   */
+  int timeouts;
+
+  /**
+   * Number of files on which the extraction engines disagree, or the query
+   * gives different entities when pruned, when checked.
+   */
+  int disagreements;
+};
 
 /**
  * C++ source parser.
@@ -11,7 +98,15 @@ public:
   /**
    * Constructor.
    */
-  Parser(const std::unordered_map<std::string,std::string>& defines);
+  Parser(const define_map& defines);
+
+  /**
+   * Copy constructor.
+   * 
+   * The new parser has its own arena, so that it may be used on a different
+   * thread, but shares the query and defines of @p o, which are immutable.
+   */
+  Parser(const Parser& o);
 
   /**
    * Destructor.
@@ -22,19 +117,366 @@ public:
    * Parse C++ source.
    * 
    * @param file C++ source file name.
+   * @param source C++ source.
    * @param global Global namespace.
+   * @param offset Offset to add to line numbers in @p source to give line
+   * numbers in @p file, when @p source is a chunk of it.
+   * 
+   * @return False if the parse exceeded its time budget, in which case
+   * @p global may be missing entities, and should not be cached.
+   */
+  bool parse(const std::string& file, const std::string& source,
+      Entity& global, const int offset = 0);
+
+  /**
+   * Names of defines referenced by C++ source.
+   * 
+   * @param source C++ source.
+   * 
+   * @return Names, sorted.
+   * 
+   * Any identifier in the source that is the name of a define is considered
+   * a reference, including those in comments and preprocessor directives,
+   * which preprocess() would not substitute. The result is therefore a
+   * superset of the defines on which the parse depends.
+   */
+  std::vector<std::string> references(const std::string& source) const;
+
+  /**
+   * Does C++ source contain any documentation comments?
+   * 
+   * @param source C++ source.
+   * 
+   * @return False if @p source certainly contains no documentation comments,
+   * true otherwise.
+   * 
+   * This is a byte scan for the opening markers of documentation comments,
+   * made without parsing. A file for which it returns false can only
+   * contribute undocumented entities, which are discarded, so need not be
+   * parsed.
+   */
+  static bool documented(const std::string_view& source);
+
+  /**
+   * Extraction engine.
+   */
+  Extractor extractor;
+
+  /**
+   * Maximum number of in-progress query matches, or zero for the tree-sitter
+   * default.
    */
-  void parse(const std::string& file, Entity& global);
+  uint32_t matchLimit;
+
+  /**
+   * Time budget for parsing each file, in milliseconds, or zero for no
+   * limit.
+   */
+  uint64_t timeBudget;
+
+  /**
+   * Maximum number of rounds of error recovery for each file.
+   */
+  int maxRecoveryRounds;
+
+  /**
+   * Aliases for commands, from alias to command name.
+   */
+  string_map aliases;
+
+  /**
+   * Custom commands, from name to Markdown replacement.
+   */
+  string_map commands;
+
+  /**
+   * Statistics.
+   */
+  ParserStats stats;
 
 private:
+  /**
+   * Entity on the stack used to nest entities while parsing.
+   */
+  struct Frame {
+    /**
+     * Entity.
+     */
+    Entity entity;
+
+    /**
+     * Match of the entity, giving its byte range in the source.
+     */
+    Match match;
+
+    /**
+     * Are the name and declaration of the entity still to be copied from
+     * the source?
+     */
+    bool lazy;
+  };
+
+  /**
+   * Pop the top frame of the stack, adding its entity to its parent.
+   * 
+   * @param frames Stack.
+   * @param in Preprocessed C++ source.
+   * 
+   * The entity is moved into its parent, along with its whole subtree, so
+   * that finished subtrees are never copied, however deep the nesting. It is
+   * discarded, without copying its name or declaration, if it is
+   * undocumented or hidden, or if it would be added to a parent that is.
+   * The documentation of an entity is complete by the time it is popped, and
+   * of its parent by the time any child is pushed.
+   */
+  void pop(std::vector<Frame>& frames, const std::string_view& in);
+
+  /**
+   * Copy the name and declaration of an entity from the source, if not
+   * already done.
+   * 
+   * @param frame Frame of the entity.
+   * @param in Preprocessed C++ source.
+   */
+  static void materialize(Frame& frame, const std::string_view& in);
+
+  /**
+   * Build entities from matches.
+   * 
+   * @param matches Matches, in order. Declarations are trimmed in place.
+   * @param in Preprocessed C++ source.
+   * @param[in,out] global Global namespace, into which entities are added.
+   */
+  void build(std::vector<Match>& matches, const std::string_view& in,
+      Entity& global);
+
   /**
    * Preprocess C++ source.
    * 
    * @param file C++ source file name.
+   * @param source C++ source.
+   * @param[out] in Preprocessed C++ source.
+   * @param offset Offset to add to line numbers in warnings.
+   * 
+   * @return Parse tree of the preprocessed source, which the caller must
+   * delete.
+   * 
+   * All uses of defines are found in a single pass over the parse tree,
+   * visiting only those subtrees that contain them, then replaced together,
+   * with a single reparse. Error recovery proceeds in
+   * rounds, each erasing one candidate macro use for every parse error, with
+   * a single reparse, up to maxRecoveryRounds.
    * 
-   * @return Preprocessed source.
+   * If the time budget runs out during the first parse, the file is skipped
+   * and `nullptr` returned. If it runs out during a later reparse, the tree
+   * from before that reparse is returned instead, i.e. without replacement
+   * of defines, or without further error recovery.
    */
-  std::string preprocess(const std::string& file);
+  TSTree* preprocess(const std::string& file, const std::string& source,
+      std::string& in, const int offset);
+
+  /**
+   * Parse C++ source within what remains of the time budget.
+   * 
+   * @param old Previous parse tree of the source, if edited, otherwise
+   * `nullptr`.
+   * @param in C++ source.
+   * 
+   * @return Parse tree, or `nullptr` if the time budget ran out, in which
+   * case `timedOut` is set.
+   */
+  TSTree* reparse(const TSTree* old, const std::string& in);
+
+  /**
+   * Milliseconds elapsed since the start of the current file.
+   */
+  uint64_t elapsed() const;
+
+  /**
+   * Extract entities and documentation comments from a parse tree.
+   * 
+   * @param node Root node.
+   * @param in Preprocessed C++ source.
+   * @param[out] matches Matches, in order.
+   */
+  void extract(TSNode node, const std::string_view& in,
+      std::vector<Match>& matches);
+
+  /**
+   * Extract entities and documentation comments from a parse tree with the
+   * query, running it only over the parts that may be documented. This is
+   * the default engine.
+   * 
+   * @param node Root node.
+   * @param in Preprocessed C++ source.
+   * @param[out] matches Matches, in order.
+   * 
+   * @see scope()
+   */
+  void search(TSNode node, const std::string_view& in,
+      std::vector<Match>& matches);
+
+  /**
+   * Extract entities and documentation comments from the children of a
+   * scope, using the query only where the result may be documented.
+   * 
+   * @param node Scope, e.g. the translation unit, a namespace, a linkage
+   * specification or a preprocessor conditional.
+   * @param in Preprocessed C++ source.
+   * @param markers Byte offsets in @p in of possible documentation comments.
+   * @param cursor Query cursor.
+   * @param[in,out] pending Is there a documentation comment not yet
+   * attached to an entity?
+   * @param[out] matches Matches, to which those found are appended.
+   * 
+   * A child that is not itself a scope is queried only if it contains a
+   * marker, follows a documentation comment not yet attached to an entity,
+   * or precedes a documentation comment that attaches to the entity before
+   * it. Any other child can only produce undocumented entities, which are
+   * discarded, so is skipped without visiting its subtree. For a namespace,
+   * the query runs over the byte range of its head only.
+   */
+  void scope(TSNode node, const std::string_view& in,
+      const std::vector<uint32_t>& markers, TSQueryCursor* cursor,
+      bool& pending, std::vector<Match>& matches);
+
+  /**
+   * Run the query over a subtree.
+   * 
+   * @param node Root of the subtree.
+   * @param start Start of the byte range to query.
+   * @param end End of the byte range to query.
+   * @param in Preprocessed C++ source.
+   * @param cursor Query cursor.
+   * @param[in,out] pending Is there a documentation comment not yet
+   * attached to an entity?
+   * @param[out] matches Matches, to which those found are appended.
+   * 
+   * If the query exceeds its match limit, in-progress matches may have been
+   * dropped, so the results are discarded and the query is run again, once,
+   * over the same range without limit. As scope() runs the query separately
+   * for each declaration in a scope, only the declaration that exceeded the
+   * limit is extracted again. No narrower window is possible, as one that
+   * ends before the declaration does would drop the match for the
+   * declaration itself.
+   */
+  void run(TSNode node, const uint32_t start, const uint32_t end,
+      const std::string_view& in, TSQueryCursor* cursor, bool& pending,
+      std::vector<Match>& matches);
+
+  /**
+   * Find the next opening marker of a documentation comment.
+   * 
+   * @param first Start of the range to search.
+   * @param last End of the range to search.
+   * 
+   * @return Position of the marker, or `nullptr` if there is none.
+   */
+  static const char* marker(const char* first, const char* last);
+
+  /**
+   * Classify a comment by its opening.
+   * 
+   * @param comment Comment.
+   * 
+   * @return `AFTER_OPEN` or `BEFORE_OPEN` for a documentation comment,
+   * otherwise `NONE`.
+   * 
+   * Only the opening characters are checked, in place.
+   */
+  static int classify(const std::string_view& comment);
+
+  /**
+   * Coalesce consecutive line documentation comments.
+   * 
+   * @param in Source.
+   * @param[in,out] matches Matches, in which each run of line documentation
+   * comments of the same kind (`AFTER_OPEN` or `BEFORE_OPEN`), separated
+   * only by whitespace, is replaced by a single match covering the run.
+   * 
+   * A block of `///` lines is then translated as one comment, so that
+   * paragraphs and indentation carry across lines.
+   */
+  static void coalesce(const std::string_view& in, std::vector<Match>& matches);
+
+  /**
+   * Scan C++ source for identifiers that are the names of defines.
+   * 
+   * @param source C++ source.
+   * 
+   * @return Each such identifier, in order, as a view into @p source.
+   */
+  std::vector<std::string_view> scan(const std::string_view& source) const;
+
+  /**
+   * Expand defines in text.
+   * 
+   * @param text Text, e.g. a use of a define, or the replacement of one.
+   * @param[out] out String to which to append the expansion.
+   * @param active Names of the defines currently being expanded, which are
+   * not expanded again.
+   */
+  void expand(const std::string_view& text, std::string& out,
+      std::set<std::string>& active);
+
+  /**
+   * Substitute arguments for the parameters of a function-like define.
+   * 
+   * @param define Define.
+   * @param args Arguments.
+   * @param active Names of the defines currently being expanded.
+   * @param[out] out String to which to append the replacement, with
+   * arguments substituted, for rescanning.
+   * 
+   * @return False if the number of arguments does not match the number of
+   * parameters, in which case nothing is appended.
+   * 
+   * As for the C preprocessor, arguments are expanded before substitution,
+   * except where operands of `#`, which quotes them, or `##`, which joins
+   * them to adjacent tokens.
+   */
+  bool substitute(const Define& define, std::vector<std::string_view> args,
+      std::set<std::string>& active, std::string& out);
+
+  /**
+   * Find the arguments of a use of a function-like define.
+   * 
+   * @param text Text.
+   * @param from Position in @p text just after the name of the define.
+   * @param[out] args Arguments, trimmed of whitespace.
+   * 
+   * @return Position in @p text just after the closing parenthesis, or
+   * `npos` if the name is not followed by an argument list, or that list is
+   * not closed before a `;` or `}` outside parentheses.
+   */
+  static size_t invocation(const std::string_view& text, const size_t from,
+      std::vector<std::string_view>& args);
+
+  /**
+   * Find the end of a string or character literal.
+   * 
+   * @param text Text.
+   * @param from Position in @p text of the opening quote.
+   * 
+   * @return Position in @p text just after the closing quote.
+   */
+  static size_t literal(const std::string_view& text, const size_t from);
+
+  /**
+   * Is a string the name of a define?
+   * 
+   * Strings are first checked against the lengths and initial characters of
+   * the names of defines, so that most can be rejected without hashing.
+   */
+  bool isDefine(const std::string_view& str) const;
+
+  /**
+   * Move a tree cursor to the next node in a depth-first traversal.
+   * 
+   * @param cursor Cursor.
+   * @param descend Descend into the children of the current node, if any?
+   */
+  static void next(TSTreeCursor& cursor, const bool descend);
 
   /**
    * Translate documentation comment.
@@ -47,15 +489,105 @@ private:
   /**
    * Defines.
    */
-  std::unordered_map<std::string,std::string> defines;
+  const define_map& defines;
 
   /**
-   * C++ parser.
+   * C++ parser, created for each file within the arena.
    */
   TSParser* parser;
 
   /**
-   * C++ query.
+   * Arena for tree-sitter allocations.
+   */
+  Arena arena;
+
+  /**
+   * C++ query, shared between copies.
+   */
+  std::shared_ptr<TSQuery> query;
+
+  /**
+   * Walk extraction engine.
+   */
+  Walker walker;
+
+  /**
+   * Did the query exceed its match limit on the current file?
+   */
+  bool exceeded;
+
+  /**
+   * Did the parse exceed its time budget on the current file?
+   */
+  bool timedOut;
+
+  /**
+   * Suppress warnings when translating documentation, as when translating
+   * it a second time?
+   */
+  bool quiet;
+
+  /**
+   * Start of the first match on which the extraction engines disagree on
+   * the current file, when checked, or the maximum value if they agree.
+   */
+  uint32_t disagreement;
+
+  /**
+   * Start time of the current file.
+   */
+  std::chrono::steady_clock::time_point started;
+
+  /**
+   * Capture kinds, indexed by capture id.
+   */
+  std::vector<Capture> captures;
+
+  /**
+   * Entity types, indexed by capture id, for captures of kind
+   * Capture::ENTITY.
+   */
+  std::vector<EntityType> types;
+
+  /**
+   * Grammar symbols for identifiers, which may be uses of defines.
+   */
+  std::set<TSSymbol> identifiers;
+
+  /**
+   * Grammar symbols for preprocessor definitions, within which defines are
+   * not replaced.
+   */
+  std::set<TSSymbol> definitions;
+
+  /**
+   * Grammar symbols for comments.
+   */
+  std::set<TSSymbol> comments;
+
+  /**
+   * Grammar symbols for namespace definitions.
+   */
+  std::set<TSSymbol> namespaces;
+
+  /**
+   * Grammar symbols for other scopes, whose children are queried
+   * separately.
+   */
+  std::set<TSSymbol> scopes;
+
+  /**
+   * Initial characters of the names of defines.
+   */
+  std::bitset<256> initials;
+
+  /**
+   * Minimum length of the names of defines.
+   */
+  size_t minLength;
+
+  /**
+   * Maximum length of the names of defines.
    */
-  TSQuery* query;
+  size_t maxLength;
 };
@@ -0,0 +1,33 @@
+#include "SourceMap.hpp"
+
+void SourceMap::replace(const uint32_t from, const uint32_t to,
+    const uint32_t first, const uint32_t last) {
+  assert(replacements.empty() || replacements.back().last <= first);
+  replacements.push_back({from, to, first, last});
+}
+
+uint32_t SourceMap::byte(const uint32_t offset) const {
+  /* find the last replacement starting at or before the offset */
+  auto iter = std::upper_bound(replacements.begin(), replacements.end(),
+      offset, [](const uint32_t offset, const Replacement& r) {
+        return offset < r.first;
+      });
+  if (iter == replacements.begin()) {
+    return offset;
+  }
+  --iter;
+  if (offset < iter->last) {
+    return iter->from;
+  } else {
+    return iter->to + (offset - iter->last);
+  }
+}
+
+TSPoint SourceMap::point(const std::string_view& source,
+    const uint32_t offset) const {
+  uint32_t b = std::min<uint32_t>(byte(offset), source.size());
+  std::string_view before = source.substr(0, b);
+  uint32_t row = std::count(before.begin(), before.end(), '\n');
+  uint32_t column = b - (before.rfind('\n') + 1);  // npos + 1 == 0
+  return TSPoint{row, column};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "doxide.hpp"
+
+/**
+ * Map from positions in preprocessed C++ source back to positions in the
+ * original source, so that diagnostics report the line and column numbers
+ * that the user sees.
+ */
+class SourceMap {
+public:
+  /**
+   * Record a replacement.
+   * 
+   * @param from Start of the replaced range in the original source.
+   * @param to End of the replaced range in the original source.
+   * @param first Start of the replacement in the preprocessed source.
+   * @param last End of the replacement in the preprocessed source.
+   * 
+   * Replacements must be recorded in order of position.
+   */
+  void replace(const uint32_t from, const uint32_t to, const uint32_t first,
+      const uint32_t last);
+
+  /**
+   * Map a byte offset in the preprocessed source to a byte offset in the
+   * original source. An offset within a replacement maps to the start of the
+   * range that it replaced.
+   */
+  uint32_t byte(const uint32_t offset) const;
+
+  /**
+   * Map a byte offset in the preprocessed source to a row and column in the
+   * original source.
+   * 
+   * @param source Original source.
+   * @param offset Byte offset in the preprocessed source.
+   */
+  TSPoint point(const std::string_view& source, const uint32_t offset) const;
+
+private:
+  /**
+   * Replacement.
+   */
+  struct Replacement {
+    uint32_t from, to, first, last;
+  };
+
+  /**
+   * Replacements, in order of position.
+   */
+  std::vector<Replacement> replacements;
+};
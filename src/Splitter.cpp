@@ -0,0 +1,240 @@
+#include "Splitter.hpp"
+
+Splitter::Splitter(const size_t size) :
+    size(size) {
+  //
+}
+
+std::vector<Chunk> Splitter::split(const std::string_view& source) const {
+  std::vector<Chunk> chunks;
+  std::vector<std::string> scopes;  // heads of enclosing scopes
+  std::vector<std::string> opened;  // heads of scopes enclosing current chunk
+  std::vector<std::pair<size_t,size_t>> directives;  // conditionals to blank
+  size_t blanked = 0;  // number of directives blanked so far
+  std::vector<size_t> conditionals;  // brace depth at each open #if
+  int other = 0;  // depth of braces that are not scopes
+  bool terminated = false;  // does the block in other need a semicolon?
+  bool end = false;  // is the last token the end of a declaration?
+  char last = 0;  // last character of the last token
+  size_t head = std::string_view::npos;  // start of current statement
+  bool line = true;  // only whitespace so far on this line?
+  size_t from = 0;  // start of current chunk
+  int row = 0, fromRow = 0;
+
+  /* emit the chunk from the start of the current chunk to a given end */
+  auto emit = [&](const size_t to) {
+    Chunk chunk;
+    for (auto& scope : opened) {
+      chunk.source.append(scope);
+      chunk.source.append(" { ");
+    }
+    chunk.source.push_back('\n');
+    size_t first = chunk.source.size();
+    chunk.source.append(source.substr(from, to - from));
+    while (blanked < directives.size() && directives[blanked].second <= to) {
+      auto [k, l] = directives[blanked++];
+      for (size_t i = k; i < l; ++i) {
+        if (chunk.source[first + i - from] != '\n') {
+          chunk.source[first + i - from] = ' ';
+        }
+      }
+    }
+    chunk.source.push_back('\n');
+    chunk.source.append(scopes.size(), '}');
+    chunk.source.push_back('\n');
+    chunk.offset = fromRow - 1;
+    chunks.push_back(std::move(chunk));
+  };
+
+  size_t i = 0, n = source.size();
+  while (i < n) {
+    char c = source[i];
+    char d = (i + 1 < n) ? source[i + 1] : 0;
+    size_t j = i + 1;  // end of token
+    if (c == '\n') {
+      ++row;
+      line = true;
+      if (other == 0 && end && j - from >= size && j < n &&
+          !isAfter(source.substr(j))) {
+        emit(j);
+        opened = scopes;
+        from = j;
+        fromRow = row;
+      }
+      i = j;
+      continue;
+    } else if (std::isspace((unsigned char)c)) {
+      i = j;
+      continue;
+    } else if (line && other == 0 && (std::isupper((unsigned char)c) ||
+        c == '_') && isMacro(source.substr(i,
+        source.find('\n', i) - i))) {
+      /* a macro alone on a line, e.g. one that opens a namespace, may hide
+       * a scope from the scan */
+      return {};
+    } else if (line && c == '#') {
+      /* preprocessor directive, to the end of the line, with continuations;
+       * conditionals are recorded to blank */
+      while (j < n && (source[j] != '\n' || source[j - 1] == '\\')) {
+        ++j;
+      }
+      std::string_view directive = source.substr(i + 1, j - i - 1);
+      size_t k = directive.find_first_not_of(" \t");
+      if (k != std::string_view::npos) {
+        directive.remove_prefix(k);
+        if (directive.starts_with("if") || directive.starts_with("elif") ||
+            directive.starts_with("else") || directive.starts_with("endif")) {
+          directives.push_back({i, j});
+
+          /* each branch must leave the brace depth unchanged, otherwise
+           * braces would be miscounted, as all branches are scanned */
+          size_t depth = scopes.size() + other;
+          if (directive.starts_with("if")) {
+            conditionals.push_back(depth);
+          } else if (!conditionals.empty() && conditionals.back() != depth) {
+            return {};
+          } else if (directive.starts_with("endif") &&
+              !conditionals.empty()) {
+            conditionals.pop_back();
+          }
+        }
+      }
+      last = '#';
+    } else if (c == '/' && d == '/') {
+      /* line comment, which makes this no place to split until after the
+       * next declaration, in case it is documentation */
+      while (j < n && source[j] != '\n') {
+        ++j;
+      }
+      last = '/';
+    } else if (c == '/' && d == '*') {
+      /* block comment, likewise */
+      size_t k = source.find("*/", i + 2);
+      j = (k == std::string_view::npos) ? n : k + 2;
+      last = '/';
+    } else if (c == '"' && i > 0 && source[i - 1] == 'R') {
+      /* raw string literal */
+      size_t k = source.find('(', j);
+      if (k == std::string_view::npos) {
+        j = n;
+      } else {
+        std::string close = ")";
+        close.append(source.substr(j, k - j));
+        close.push_back('"');
+        k = source.find(close, k);
+        j = (k == std::string_view::npos) ? n : k + close.size();
+      }
+      last = c;
+    } else if ((c == '"' || c == '\'') && !(c == '\'' && i > 0 &&
+        std::isdigit((unsigned char)source[i - 1]) &&
+        std::isalnum((unsigned char)d))) {
+      /* string or character literal, but not a digit separator */
+      while (j < n && source[j] != c && source[j] != '\n') {
+        j += (source[j] == '\\') ? 2 : 1;
+      }
+      j = std::min(j + 1, n);
+      last = c;
+    } else if (c == '{') {
+      if (other > 0) {
+        ++other;
+      } else if (head != std::string_view::npos &&
+          isScope(source.substr(head, i - head))) {
+        std::string scope(source.substr(head, i - head));
+        std::replace(scope.begin(), scope.end(), '\n', ' ');
+        std::replace(scope.begin(), scope.end(), '\r', ' ');
+        scopes.push_back(scope);
+      } else {
+        other = 1;
+        terminated = head != std::string_view::npos &&
+            isTerminated(source.substr(head, i - head));
+      }
+      head = std::string_view::npos;
+      last = c;
+    } else if (c == '}') {
+      if (other > 0) {
+        --other;
+      } else if (!scopes.empty()) {
+        scopes.pop_back();
+      } else {
+        /* unmatched, so some scope was opened other than by a brace */
+        return {};
+      }
+      /* a declarator may follow, as in "} name;", if a semicolon is due */
+      if (other == 0 && terminated) {
+        terminated = false;
+        head = i;
+      } else {
+        head = std::string_view::npos;
+      }
+      last = c;
+    } else if (c == ';') {
+      head = std::string_view::npos;
+      last = c;
+    } else {
+      last = c;
+    }
+    end = (last == ';' || last == '}') && head == std::string_view::npos;
+
+    /* the first token of a statement starts its head */
+    if (head == std::string_view::npos && c != '{' && c != '}' && c != ';' &&
+        last != '#' && last != '/') {
+      head = i;
+    }
+    row += std::count(source.begin() + i, source.begin() + j, '\n');
+    line = false;
+    i = j;
+  }
+  if (other != 0 || !scopes.empty() || !conditionals.empty()) {
+    return {};
+  }
+  emit(n);
+  return chunks;
+}
+
+bool Splitter::isTerminated(const std::string_view& head) {
+  static const std::regex keyword(
+      R"(\b(struct|class|union|enum|typedef)\b|=)");
+  return std::regex_search(head.begin(), head.end(), keyword);
+}
+
+bool Splitter::isAfter(const std::string_view& line) {
+  size_t k = line.find_first_not_of(" \t\r");
+  if (k == std::string_view::npos) {
+    return false;
+  }
+  std::string_view open = line.substr(k, 4);
+  return open == "///<" || open == "//!<" || open == "/**<" || open == "/*!<";
+}
+
+bool Splitter::isMacro(const std::string_view& line) {
+  static const std::regex macro(
+      R"([A-Z_][A-Z0-9_]*\s*(\([^()]*\))?\s*(//.*|/\*.*)?)");
+  return std::regex_match(line.begin(), line.end(), macro);
+}
+
+bool Splitter::isScope(const std::string_view& head) {
+  auto word = [](std::string_view& str, const std::string_view& word) {
+    if (str.starts_with(word) && (str.size() == word.size() ||
+        !(std::isalnum((unsigned char)str[word.size()]) ||
+        str[word.size()] == '_'))) {
+      str.remove_prefix(word.size());
+      size_t k = str.find_first_not_of(" \t\r\n");
+      str.remove_prefix(k == std::string_view::npos ? str.size() : k);
+      return true;
+    }
+    return false;
+  };
+
+  std::string_view str = head;
+  if (word(str, "namespace")) {
+    return true;
+  } else if (word(str, "inline")) {
+    return word(str, "namespace");
+  } else if (word(str, "extern") && str.starts_with('"')) {
+    /* linkage specification, but not a function with one */
+    size_t k = str.find('"', 1);
+    return k != std::string_view::npos &&
+        str.find_first_not_of(" \t\r\n", k + 1) == std::string_view::npos;
+  }
+  return false;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "doxide.hpp"
+
+/**
+ * Chunk of a C++ source file, which can be parsed on its own.
+ */
+struct Chunk {
+  /**
+   * Source of the chunk. The first line opens the namespaces and linkage
+   * specifications that enclose the chunk in the original file, and the
+   * last line closes those that enclose its end.
+   */
+  std::string source;
+
+  /**
+   * Offset to add to a line number in the chunk to give the line number in
+   * the original file.
+   */
+  int offset;
+};
+
+/**
+ * Splitter of large C++ source files into chunks that can be parsed in
+ * parallel.
+ *
+ * Files are split at the start of a line following the end of a declaration
+ * (a semicolon or closing brace) that is enclosed only by namespaces and
+ * linkage specifications, as found by a lexical scan that skips comments,
+ * literals and preprocessor directives, and not before a comment that
+ * documents the preceding entity. A documentation comment is therefore
+ * never separated from the entity that it documents. As a chunk may begin
+ * or end within a preprocessor conditional, conditional directives are
+ * blanked in all chunks, which leaves the parse of the code between them
+ * unchanged, as both branches are parsed anyway.
+ *
+ * A file is not split where the scan may be mistaken: braces that do not
+ * balance, a conditional branch that opens or closes a brace, or a macro
+ * alone on a line at namespace scope, which may open or close a namespace.
+ */
+class Splitter {
+public:
+  /**
+   * Constructor.
+   *
+   * @param size Minimum size of a chunk, in bytes.
+   */
+  Splitter(const size_t size);
+
+  /**
+   * Split C++ source.
+   *
+   * @param source C++ source.
+   *
+   * @return Chunks, in order. Fewer than two means that @p source is too
+   * small or could not be split, and should be parsed whole instead.
+   */
+  std::vector<Chunk> split(const std::string_view& source) const;
+
+private:
+  /**
+   * Is the head of a brace-enclosed block that of a namespace or linkage
+   * specification?
+   */
+  static bool isScope(const std::string_view& head);
+
+  /**
+   * Is the head of a brace-enclosed block that of a declaration that ends
+   * with a semicolon after the closing brace, as for a class or
+   * initializer?
+   */
+  static bool isTerminated(const std::string_view& head);
+
+  /**
+   * Does a line start with a comment that documents the entity before it?
+   */
+  static bool isAfter(const std::string_view& line);
+
+  /**
+   * Is a line a macro alone, with any arguments and trailing comment?
+   */
+  static bool isMacro(const std::string_view& line);
+
+  /**
+   * Minimum size of a chunk, in bytes.
+   */
+  size_t size;
+};
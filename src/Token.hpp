@@ -22,31 +22,6 @@ enum TokenType : int {
   ANY = ~0
 };
 
-/**
- * Token patterns. Order is important, as a match to an earlier pattern
- * precludes a match to a later.
- */
-static auto regexes = {
-  std::make_pair(AFTER_OPEN, std::regex("(?:/\\*\\*|/\\*!|///|//!)<")),
-  std::make_pair(BEFORE_OPEN, std::regex("(?:/\\*\\*|/\\*!|///|//!)")),
-  std::make_pair(CLOSE, std::regex("\\*/")),
-  std::make_pair(COMMAND, std::regex("[@\\\\](?:param(?:\\[(?:in|out|in,out)\\])?|\\w+|@|/|f[\\$\\[\\]])")),
-
-  /* the end of a paragraph is either two new lines or one new line with a
-   * command to come */
-  std::make_pair(PARA, std::regex("\\s*\\n[ \t]*(?:\\*(?!/))?[ \t]*(?:(?=@)|\\n[ \t]*(?:\\*(?!/))?[ \t]*)")),
-
-  /* the end of a line is one new line, as long as there is not a command to
-   * come (which would denote the end of a paragraph instead) */
-  std::make_pair(LINE, std::regex("\\s*\\n[ \t]*(?:\\*(?!/))?[ \t]*(?!@)")),
-
-  std::make_pair(SENTENCE, std::regex("[.!?]")),
-  std::make_pair(WHITESPACE, std::regex("\\s+")),
-  std::make_pair(WORD, std::regex("[^@\\s\\*/]+")),
-  std::make_pair(STAR, std::regex("\\*")),
-  std::make_pair(SLASH, std::regex("/"))
-};
-
 /**
  * Token.
  * 
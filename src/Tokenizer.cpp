@@ -1,6 +1,55 @@
 #include "Tokenizer.hpp"
 
-Tokenizer::Tokenizer(const std::string_view& source) {
+/**
+ * Character classes, as bit flags.
+ */
+enum CharClass : uint8_t {
+  /**
+   * Whitespace, as for `\s`.
+   */
+  SPACE_CHAR = 1 << 0,
+
+  /**
+   * Space or tab, as for `[ \t]`.
+   */
+  BLANK_CHAR = 1 << 1,
+
+  /**
+   * Word character, as for `\w`.
+   */
+  WORD_CHAR = 1 << 2,
+
+  /**
+   * Character that ends a word, as for `[@\s*\/]`.
+   */
+  BREAK_CHAR = 1 << 3
+};
+
+/**
+ * Character class table, indexed by character.
+ */
+static constexpr auto classes = []() {
+  std::array<uint8_t,256> table{};
+  for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+    table[c] |= SPACE_CHAR|BREAK_CHAR;
+  }
+  for (unsigned char c : {' ', '\t'}) {
+    table[c] |= BLANK_CHAR;
+  }
+  for (int c = 0; c < 256; ++c) {
+    if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+        ('0' <= c && c <= '9') || c == '_') {
+      table[c] |= WORD_CHAR;
+    }
+  }
+  for (unsigned char c : {'@', '*', '/'}) {
+    table[c] |= BREAK_CHAR;
+  }
+  return table;
+}();
+
+Tokenizer::Tokenizer(const std::string_view& source, const bool lines) :
+    lines(lines) {
   iter = source.cbegin();
   end = source.cend();
 }
@@ -8,17 +57,135 @@ Tokenizer::Tokenizer(const std::string_view& source) {
 Token Tokenizer::next() {
   Token token(NONE, iter, iter);
   if (iter != end) {
-    for (auto& [type, regex] : regexes) {
-      std::match_results<std::string_view::const_iterator> match;
-      if (std::regex_search(iter, end, match, regex,
-          std::regex_constants::match_continuous)) {
-        iter += match.length();
-        token.type = type;
-        token.last = iter;
-        return token;
+    const char* s = &*iter;
+    const size_t n = std::distance(iter, end);
+
+    /* character at a position, or NUL past the end, which is in no class
+     * and matches no character tested below, as for a real NUL */
+    auto at = [&](const size_t k) {
+      return k < n ? s[k] : '\0';
+    };
+    auto is = [&](const size_t k, const uint8_t cls) {
+      return k < n && (classes[(unsigned char)s[k]] & cls);
+    };
+    auto skip = [&](size_t k, const uint8_t cls) {
+      while (is(k, cls)) {
+        ++k;
+      }
+      return k;
+    };
+    /* one character at a time; the words of documentation comments are too
+     * short for a vector scan to pay off */
+    auto word = [&](size_t k) {
+      while (k < n && !(classes[(unsigned char)s[k]] & BREAK_CHAR)) {
+        ++k;
+      }
+      return k;
+    };
+
+    TokenType type = NONE;
+    size_t len = 0;
+    char c = s[0];
+    if (c == '/') {
+      /* opening of documentation comment, or slash */
+      if ((at(1) == '*' && (at(2) == '*' || at(2) == '!')) ||
+          (at(1) == '/' && (at(2) == '/' || at(2) == '!'))) {
+        if (at(3) == '<') {
+          type = AFTER_OPEN;
+          len = 4;
+        } else {
+          type = BEFORE_OPEN;
+          len = 3;
+        }
+      } else {
+        type = SLASH;
+        len = 1;
+      }
+    } else if (c == '*') {
+      /* closing of comment, or star */
+      if (at(1) == '/') {
+        type = CLOSE;
+        len = 2;
+      } else {
+        type = STAR;
+        len = 1;
       }
+    } else if (c == '@' || c == '\\') {
+      /* command; "param" is tried before a run of word characters, so that
+       * e.g. "@params" is "@param" followed by a word, and a run of word
+       * characters shadows "f$", "f[" and "f]", which are never matched */
+      if (std::string_view(s, n).substr(1, 5) == "param") {
+        len = 6;
+        std::string_view rest = std::string_view(s, n).substr(len);
+        for (auto dir : {"[in]", "[out]", "[in,out]"}) {
+          if (rest.starts_with(dir)) {
+            len += std::strlen(dir);
+            break;
+          }
+        }
+      } else if (is(1, WORD_CHAR)) {
+        len = skip(1, WORD_CHAR);
+      } else if (at(1) == '@' || at(1) == '/') {
+        len = 2;
+      }
+      if (len > 0) {
+        type = COMMAND;
+      } else if (c == '\\') {
+        type = WORD;
+        len = word(1);
+      }
+    } else if (c == '.' || c == '!' || c == '?') {
+      type = SENTENCE;
+      len = 1;
+    } else if (is(0, SPACE_CHAR)) {
+      /* whitespace; the end of a paragraph is either two new lines or one
+       * new line with a command to come, while the end of a line is one
+       * new line otherwise, each followed by any blanks and decoration,
+       * which is a single star, or for a run of line comments the opening
+       * of the next line; a paragraph may end at any new line in the
+       * whitespace, trying the last first, while a line ends at the last */
+      size_t w = skip(0, SPACE_CHAR);
+      auto decoration = [&](size_t k) {
+        k = skip(k, BLANK_CHAR);
+        if (!lines && at(k) == '*' && at(k + 1) != '/') {
+          ++k;
+        } else if (lines && at(k) == '/' && at(k + 1) == '/' &&
+            (at(k + 2) == '/' || at(k + 2) == '!')) {
+          k += (at(k + 3) == '<') ? 4 : 3;
+        }
+        return skip(k, BLANK_CHAR);
+      };
+      type = WHITESPACE;
+      len = w;
+      for (size_t p = w; p > 0; --p) {
+        if (s[p - 1] == '\n') {
+          size_t r = decoration(p);
+          if (at(r) == '@') {
+            type = PARA;
+            len = r;
+            break;
+          } else if (at(r) == '\n') {
+            type = PARA;
+            len = decoration(r + 1);
+            break;
+          } else if (type == WHITESPACE) {
+            type = LINE;
+            len = r;
+          }
+        }
+      }
+    } else {
+      type = WORD;
+      len = word(1);
+    }
+
+    if (type == NONE) {
+      error("unrecognized token starting: " <<
+          std::string_view(s, n).substr(0, 40) << "...");
     }
-    error("unrecognized token starting: " << std::string(iter, iter + 40) << "...");
+    iter += len;
+    token.type = type;
+    token.last = iter;
   }
   return token;
 }
@@ -12,8 +12,11 @@ public:
    * Constructor.
    * 
    * @param comment Comment to tokenize.
+   * @param lines Is the comment a run of line comments (see
+   * Parser::coalesce())? If so, the opening of each line after the first is
+   * decoration, rather than a star.
    */
-  Tokenizer(const std::string_view& source);
+  Tokenizer(const std::string_view& source, const bool lines = false);
   
   /**
    * Get the next token.
@@ -52,4 +55,9 @@ private:
    * End of source.
    */
   std::string_view::const_iterator end;
+
+  /**
+   * Is the comment a run of line comments?
+   */
+  bool lines;
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "doxide.hpp"
+#include "Define.hpp"
+
+/**
+ * Build variant, e.g. for one platform configuration, with its own defines
+ * and output directory.
+ */
+struct Variant {
+  /**
+   * Name.
+   */
+  std::string name;
+
+  /**
+   * Defines: those of the configuration file, extended or overridden by
+   * those of the variant.
+   */
+  define_map defines;
+
+  /**
+   * Output directory.
+   */
+  std::string output;
+};
@@ -0,0 +1,392 @@
+#include "Walker.hpp"
+
+Walker::Walker() {
+  static const char* symbolNames[NUM_SYMBOLS] = {
+    "comment",
+    "namespace_definition",
+    "nested_namespace_specifier",
+    "namespace_identifier",
+    "declaration_list",
+    "template_declaration",
+    "class_specifier",
+    "struct_specifier",
+    "union_specifier",
+    "enum_specifier",
+    "field_declaration_list",
+    "enumerator_list",
+    "type_definition",
+    "alias_declaration",
+    "concept_definition",
+    "declaration",
+    "field_declaration",
+    "function_definition",
+    "init_declarator",
+    "reference_declarator",
+    "pointer_declarator",
+    "function_declarator",
+    "field_initializer_list",
+    "operator_cast",
+    "operator_name",
+    "destructor_name",
+    "enumerator",
+    "preproc_def",
+    "preproc_function_def",
+    "identifier",
+    "field_identifier",
+    "type_identifier"
+  };
+  static const char* fieldNames[NUM_FIELDS] = {
+    "name",
+    "body",
+    "declarator",
+    "value",
+    "default_value",
+    "type"
+  };
+
+  for (int i = 0; i < NUM_SYMBOLS; ++i) {
+    symbols[i] = ts_language_symbol_for_name(tree_sitter_cpp(),
+        symbolNames[i], strlen(symbolNames[i]), true);
+  }
+  for (int i = 0; i < NUM_FIELDS; ++i) {
+    fields[i] = ts_language_field_id_for_name(tree_sitter_cpp(),
+        fieldNames[i], strlen(fieldNames[i]));
+  }
+}
+
+void Walker::walk(TSNode node, std::vector<Match>& matches) const {
+  std::vector<Pending> pending;
+  TSTreeCursor cursor = ts_tree_cursor_new(node);
+  TSTreeCursor children = ts_tree_cursor_new(node);
+  TSTreeCursor grandchildren = ts_tree_cursor_new(node);
+  bool done = false;
+  while (!done) {
+    /* enter */
+    node = ts_tree_cursor_current_node(&cursor);
+    complete(node, false, pending, matches);
+    if (ts_node_is_named(node)) {
+      match(node, children, grandchildren, pending, matches);
+    }
+
+    /* move to the next node, leaving all those that are finished */
+    if (!ts_tree_cursor_goto_first_child(&cursor)) {
+      complete(node, true, pending, matches);
+      while (!done && !ts_tree_cursor_goto_next_sibling(&cursor)) {
+        if (ts_tree_cursor_goto_parent(&cursor)) {
+          complete(ts_tree_cursor_current_node(&cursor), true, pending,
+              matches);
+        } else {
+          done = true;
+        }
+      }
+    }
+  }
+  ts_tree_cursor_delete(&grandchildren);
+  ts_tree_cursor_delete(&children);
+  ts_tree_cursor_delete(&cursor);
+  assert(pending.empty());
+}
+
+void Walker::match(TSNode node, TSTreeCursor& children,
+    TSTreeCursor& grandchildren, std::vector<Pending>& pending,
+    std::vector<Match>& matches) const {
+  static const TSNode null{};
+
+  /* complete a match on entering its final node or, if there is none because
+   * a trailing optional capture is absent, on leaving the whole match */
+  auto add = [&](const Match& match, TSNode last) {
+    if (ts_node_is_null(last)) {
+      pending.push_back({node, true, match});
+    } else {
+      pending.push_back({last, false, match});
+    }
+  };
+
+  /* in one pass over the named children, call emit() for each child that
+   * satisfies head(), in order, with the first child after it that
+   * satisfies tail(), or a null node if there is none */
+  auto pairs = [&](auto head, auto tail, auto emit) {
+    std::vector<Child> waiting;
+    for (bool more = first(children, node); more; more = next(children)) {
+      Child c = child(children);
+      if (!waiting.empty() && tail(c)) {
+        for (auto& w : waiting) {
+          emit(w, c.node);
+        }
+        waiting.clear();
+      }
+      if (head(c)) {
+        waiting.push_back(c);
+      }
+    }
+    for (auto& w : waiting) {
+      emit(w, null);
+    }
+  };
+
+  /* patterns are tried in the same order as in the query, so that matches
+   * completed by the same node are in the same order */
+  if (is(node, COMMENT)) {
+    matches.push_back(make(EntityType::NONE, node, null, null));
+  }
+
+  if (is(node, NAMESPACE_DEFINITION)) {
+    auto body = [&](const Child& c) {
+      return c.field == fields[BODY] && is(c.node, DECLARATION_LIST);
+    };
+    pairs([&](const Child& c) {
+      return c.field == fields[NAME] && is(c.node, NAMESPACE_IDENTIFIER);
+    }, body, [&](const Child& c, TSNode body) {
+      add(make(EntityType::NAMESPACE, node, c.node, body), body);
+    });
+    pairs([&](const Child& c) {
+      return is(c.node, NESTED_NAMESPACE_SPECIFIER);
+    }, body, [&](const Child& c, TSNode body) {
+      for (bool more = first(grandchildren, c.node); more;
+          more = next(grandchildren)) {
+        TSNode name = ts_tree_cursor_current_node(&grandchildren);
+        if (is(name, NAMESPACE_IDENTIFIER)) {
+          add(make(EntityType::NAMESPACE, node, name, body), body);
+        }
+      }
+    });
+  }
+
+  if (is(node, TEMPLATE_DECLARATION)) {
+    for (bool more = first(children, node); more; more = next(children)) {
+      TSNode c = ts_tree_cursor_current_node(&children);
+      if (is(c, CLASS_SPECIFIER) || is(c, STRUCT_SPECIFIER) ||
+          is(c, UNION_SPECIFIER) || is(c, ALIAS_DECLARATION) ||
+          is(c, CONCEPT_DEFINITION) || is(c, DECLARATION) ||
+          is(c, FIELD_DECLARATION) || is(c, FUNCTION_DEFINITION)) {
+        add(make(EntityType::TEMPLATE, node, null, c), c);
+      }
+    }
+  }
+
+  if (is(node, CLASS_SPECIFIER) || is(node, STRUCT_SPECIFIER) ||
+      is(node, UNION_SPECIFIER) || is(node, ENUM_SPECIFIER)) {
+    Symbol list = is(node, ENUM_SPECIFIER) ?
+        ENUMERATOR_LIST : FIELD_DECLARATION_LIST;
+    pairs([&](const Child& c) {
+      return c.field == fields[NAME] && is(c.node, TYPE_IDENTIFIER);
+    }, [&](const Child& c) {
+      return c.field == fields[BODY] && is(c.node, list);
+    }, [&](const Child& c, TSNode body) {
+      add(make(EntityType::TYPE, node, c.node, body), body);
+    });
+  }
+
+  if (is(node, TYPE_DEFINITION)) {
+    Child last{null, 0};
+    for (bool more = first(children, node); more; more = next(children)) {
+      last = child(children);
+    }
+    if (last.field == fields[DECLARATOR] && is(last.node, TYPE_IDENTIFIER)) {
+      add(make(EntityType::TYPE, node, last.node, null), last.node);
+    }
+  }
+
+  if (is(node, ALIAS_DECLARATION)) {
+    for (bool more = first(children, node); more; more = next(children)) {
+      Child c = child(children);
+      if (c.field == fields[NAME] && is(c.node, TYPE_IDENTIFIER)) {
+        add(make(EntityType::TYPE, node, c.node, null), c.node);
+      }
+    }
+  }
+
+  if (is(node, CONCEPT_DEFINITION)) {
+    pairs([&](const Child& c) {
+      return c.field == fields[NAME] && is(c.node, IDENTIFIER);
+    }, [](const Child&) {
+      return true;
+    }, [&](const Child& c, TSNode last) {
+      if (!ts_node_is_null(last)) {
+        add(make(EntityType::CONCEPT, node, c.node, null), last);
+      }
+    });
+  }
+
+  if (is(node, DECLARATION) || is(node, FIELD_DECLARATION)) {
+    bool member = is(node, FIELD_DECLARATION);
+    pairs([&](const Child& c) {
+      TSNode name = null, value = null;
+      return c.field == fields[DECLARATOR] &&
+          variable(c.node, member, grandchildren, name, value);
+    }, [&](const Child& c) {
+      return c.field == fields[DEFAULT_VALUE];
+    }, [&](const Child& c, TSNode last) {
+      TSNode name = null, value = null;
+      variable(c.node, member, grandchildren, name, value);
+      if (!ts_node_is_null(last)) {
+        value = last;
+      }
+      add(make(EntityType::VARIABLE, node, name, value), last);
+    });
+  }
+
+  for (auto type : {EntityType::FUNCTION, EntityType::OPERATOR}) {
+    bool operators = type == EntityType::OPERATOR;
+    pairs([&](const Child& c) {
+      TSNode name = null;
+      return c.field == fields[DECLARATOR] &&
+          function(c.node, operators, grandchildren, name);
+    }, [&](const Child& c) {
+      return c.field == fields[BODY] ||
+          (!operators && is(c.node, FIELD_INITIALIZER_LIST));
+    }, [&](const Child& c, TSNode body) {
+      TSNode name = null;
+      function(c.node, operators, grandchildren, name);
+      add(make(type, node, name, body), body);
+    });
+  }
+
+  if (is(node, ENUMERATOR)) {
+    for (bool more = first(children, node); more; more = next(children)) {
+      Child c = child(children);
+      if (c.field == fields[NAME] && is(c.node, IDENTIFIER)) {
+        add(make(EntityType::ENUMERATOR, node, c.node, null), c.node);
+      }
+    }
+  }
+
+  if (is(node, PREPROC_DEF) || is(node, PREPROC_FUNCTION_DEF)) {
+    pairs([&](const Child& c) {
+      return c.field == fields[NAME] && is(c.node, IDENTIFIER);
+    }, [&](const Child& c) {
+      return c.field == fields[VALUE];
+    }, [&](const Child& c, TSNode value) {
+      if (!ts_node_is_null(value)) {
+        add(make(EntityType::MACRO, node, c.node, value), value);
+      }
+    });
+  }
+}
+
+void Walker::complete(TSNode node, const bool leave,
+    std::vector<Pending>& pending, std::vector<Match>& matches) {
+  size_t j = 0;
+  for (size_t i = 0; i < pending.size(); ++i) {
+    if (pending[i].leave == leave && ts_node_eq(pending[i].node, node)) {
+      matches.push_back(pending[i].match);
+    } else {
+      pending[j++] = pending[i];
+    }
+  }
+  pending.resize(j);
+}
+
+bool Walker::variable(TSNode node, const bool member, TSTreeCursor& cursor,
+    TSNode& name, TSNode& value) const {
+  /* a reference or pointer declarator matches on any identifier child */
+  auto wrapped = [&](TSNode declarator) {
+    if (is(declarator, REFERENCE_DECLARATOR) ||
+        is(declarator, POINTER_DECLARATOR)) {
+      for (bool more = first(cursor, declarator); more; more = next(cursor)) {
+        TSNode c = ts_tree_cursor_current_node(&cursor);
+        if (is(c, IDENTIFIER)) {
+          name = c;
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  if (is(node, member ? FIELD_IDENTIFIER : IDENTIFIER)) {
+    name = node;
+    return true;
+  } else if (is(node, INIT_DECLARATOR)) {
+    TSNode declarator = field(node, DECLARATOR);
+    value = field(node, VALUE);
+    if (ts_node_is_null(declarator) || ts_node_is_null(value) ||
+        !ts_node_is_named(value)) {
+      return false;
+    } else if (is(declarator, IDENTIFIER) ||
+        is(declarator, FIELD_IDENTIFIER)) {
+      name = declarator;
+      return true;
+    } else {
+      return wrapped(declarator);
+    }
+  } else {
+    return wrapped(node);
+  }
+}
+
+bool Walker::function(TSNode node, const bool operators,
+    TSTreeCursor& cursor, TSNode& name) const {
+  if (operators && is(node, OPERATOR_CAST)) {
+    name = field(node, TYPE);
+    return !ts_node_is_null(name) && ts_node_is_named(name);
+  }
+  if (is(node, REFERENCE_DECLARATOR) || is(node, POINTER_DECLARATOR)) {
+    for (bool more = first(cursor, node); more; more = next(cursor)) {
+      TSNode c = ts_tree_cursor_current_node(&cursor);
+      if (is(c, FUNCTION_DECLARATOR)) {
+        node = c;
+        break;
+      }
+    }
+  }
+  if (is(node, FUNCTION_DECLARATOR)) {
+    name = field(node, DECLARATOR);
+    if (operators) {
+      return is(name, OPERATOR_NAME);
+    } else {
+      return is(name, IDENTIFIER) || is(name, FIELD_IDENTIFIER) ||
+          is(name, DESTRUCTOR_NAME);
+    }
+  }
+  return false;
+}
+
+bool Walker::first(TSTreeCursor& cursor, TSNode node) {
+  ts_tree_cursor_reset(&cursor, node);
+  if (!ts_tree_cursor_goto_first_child(&cursor)) {
+    return false;
+  }
+  return ts_node_is_named(ts_tree_cursor_current_node(&cursor)) ||
+      next(cursor);
+}
+
+bool Walker::next(TSTreeCursor& cursor) {
+  while (ts_tree_cursor_goto_next_sibling(&cursor)) {
+    if (ts_node_is_named(ts_tree_cursor_current_node(&cursor))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Walker::Child Walker::child(TSTreeCursor& cursor) {
+  return {ts_tree_cursor_current_node(&cursor),
+      ts_tree_cursor_current_field_id(&cursor)};
+}
+
+bool Walker::is(TSNode node, const Symbol symbol) const {
+  return !ts_node_is_null(node) && ts_node_symbol(node) == symbols[symbol];
+}
+
+TSNode Walker::field(TSNode node, const Field field) const {
+  return ts_node_child_by_field_id(node, fields[field]);
+}
+
+Match Walker::make(const EntityType type, TSNode node, TSNode name,
+    TSNode middle) {
+  Match match;
+  match.type = type;
+  match.start = ts_node_start_byte(node);
+  match.end = ts_node_end_byte(node);
+  match.middle = ts_node_is_null(middle) ? match.end :
+      ts_node_start_byte(middle);
+  if (ts_node_is_null(name)) {
+    match.nameStart = match.start;
+    match.nameEnd = match.start;
+  } else {
+    match.nameStart = ts_node_start_byte(name);
+    match.nameEnd = ts_node_end_byte(name);
+  }
+  return match;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "doxide.hpp"
+#include "Match.hpp"
+
+/**
+ * Extraction engine that walks a C++ parse tree once, by grammar symbol,
+ * producing the same matches as running the C++ query.
+ *
+ * Matches are produced in the same order as by the query engine, which
+ * returns each match once its final step is reached: on entering the node
+ * of its last capture or, where that capture is optional and absent, on
+ * leaving the node of the whole match.
+ */
+class Walker {
+public:
+  /**
+   * Constructor.
+   */
+  Walker();
+
+  /**
+   * Extract matches.
+   *
+   * @param node Root node.
+   * @param[out] matches Matches, appended in order.
+   */
+  void walk(TSNode node, std::vector<Match>& matches) const;
+
+private:
+  /**
+   * Grammar symbols used by the walk.
+   */
+  enum Symbol {
+    COMMENT,
+    NAMESPACE_DEFINITION,
+    NESTED_NAMESPACE_SPECIFIER,
+    NAMESPACE_IDENTIFIER,
+    DECLARATION_LIST,
+    TEMPLATE_DECLARATION,
+    CLASS_SPECIFIER,
+    STRUCT_SPECIFIER,
+    UNION_SPECIFIER,
+    ENUM_SPECIFIER,
+    FIELD_DECLARATION_LIST,
+    ENUMERATOR_LIST,
+    TYPE_DEFINITION,
+    ALIAS_DECLARATION,
+    CONCEPT_DEFINITION,
+    DECLARATION,
+    FIELD_DECLARATION,
+    FUNCTION_DEFINITION,
+    INIT_DECLARATOR,
+    REFERENCE_DECLARATOR,
+    POINTER_DECLARATOR,
+    FUNCTION_DECLARATOR,
+    FIELD_INITIALIZER_LIST,
+    OPERATOR_CAST,
+    OPERATOR_NAME,
+    DESTRUCTOR_NAME,
+    ENUMERATOR,
+    PREPROC_DEF,
+    PREPROC_FUNCTION_DEF,
+    IDENTIFIER,
+    FIELD_IDENTIFIER,
+    TYPE_IDENTIFIER,
+    NUM_SYMBOLS
+  };
+
+  /**
+   * Grammar fields used by the walk.
+   */
+  enum Field {
+    NAME,
+    BODY,
+    DECLARATOR,
+    VALUE,
+    DEFAULT_VALUE,
+    TYPE,
+    NUM_FIELDS
+  };
+
+  /**
+   * Match awaiting its final step.
+   */
+  struct Pending {
+    /**
+     * Node on entering or leaving which the match is complete.
+     */
+    TSNode node;
+
+    /**
+     * Is the match complete on leaving @p node, rather than entering it?
+     */
+    bool leave;
+
+    /**
+     * The match.
+     */
+    Match match;
+  };
+
+  /**
+   * Child of a node, with its field.
+   */
+  struct Child {
+    TSNode node;
+    TSFieldId field;
+  };
+
+  /**
+   * Find the matches of a node.
+   *
+   * @param node Node.
+   * @param children Cursor with which to visit the children of @p node.
+   * @param grandchildren Cursor with which to visit their children.
+   * @param[out] pending Matches awaiting their final step.
+   * @param[out] matches Matches that are complete on entering @p node.
+   */
+  void match(TSNode node, TSTreeCursor& children,
+      TSTreeCursor& grandchildren, std::vector<Pending>& pending,
+      std::vector<Match>& matches) const;
+
+  /**
+   * Complete the pending matches of a node.
+   *
+   * @param node Node.
+   * @param leave Leaving @p node, rather than entering it?
+   * @param pending Matches awaiting their final step.
+   * @param[out] matches Matches, to which those completed are appended.
+   */
+  static void complete(TSNode node, const bool leave,
+      std::vector<Pending>& pending, std::vector<Match>& matches);
+
+  /**
+   * Match a variable declarator.
+   *
+   * @param node Declarator.
+   * @param member Is this the declarator of a member variable?
+   * @param cursor Cursor with which to visit the children of @p node.
+   * @param[out] name Name, if matched.
+   * @param[out] value Value, if any.
+   *
+   * @return Was the declarator matched?
+   */
+  bool variable(TSNode node, const bool member, TSTreeCursor& cursor,
+      TSNode& name, TSNode& value) const;
+
+  /**
+   * Match a function declarator.
+   *
+   * @param node Declarator.
+   * @param operators Match operators rather than functions?
+   * @param cursor Cursor with which to visit the children of @p node.
+   * @param[out] name Name, if matched.
+   *
+   * @return Was the declarator matched?
+   */
+  bool function(TSNode node, const bool operators, TSTreeCursor& cursor,
+      TSNode& name) const;
+
+  /**
+   * Move a cursor to the first named child of a node.
+   *
+   * @return Is there one?
+   *
+   * The cursor is reset to @p node, so that none is allocated per node.
+   */
+  static bool first(TSTreeCursor& cursor, TSNode node);
+
+  /**
+   * Move a cursor to the next named sibling.
+   *
+   * @return Is there one?
+   */
+  static bool next(TSTreeCursor& cursor);
+
+  /**
+   * Named child at a cursor, with its field.
+   */
+  static Child child(TSTreeCursor& cursor);
+
+  /**
+   * Is a node of a given symbol?
+   */
+  bool is(TSNode node, const Symbol symbol) const;
+
+  /**
+   * Child of a node in a given field, or a null node if there is none.
+   */
+  TSNode field(TSNode node, const Field field) const;
+
+  /**
+   * Create a match.
+   */
+  static Match make(const EntityType type, TSNode node, TSNode name,
+      TSNode middle);
+
+  /**
+   * Grammar symbol ids, indexed by Symbol.
+   */
+  std::array<TSSymbol,NUM_SYMBOLS> symbols;
+
+  /**
+   * Grammar field ids, indexed by Field.
+   */
+  std::array<TSFieldId,NUM_FIELDS> fields;
+};
@@ -391,6 +391,13 @@ int main(int argc, char** argv) {
       "Main page description.");
   app.add_option("--output", driver.output,
       "Output directory.");
+  app.add_option("-j,--jobs", driver.jobs,
+      "Number of threads to use when parsing.");
+  app.add_flag("--no-cache", driver.noCache,
+      "Do not read or write the parse cache.");
+  app.add_option("--extractor", driver.extractor,
+      "Extraction engine, 'query' or 'walk', or 'check' to compare them.")->
+      check(CLI::IsMember({"query", "walk", "check"}));
   app.add_subcommand("init",
       "Initialize configuration files.")->
       fallthrough()->
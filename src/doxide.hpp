@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string>
+#include <array>
 #include <regex>
 #include <stack>
 #include <list>
+#include <set>
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
@@ -13,6 +15,17 @@
 #include <sstream>
 #include <iomanip>
 #include <variant>
+#include <bitset>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <bit>
 
 #include <cassert>
 
@@ -22,17 +35,52 @@
 #include <CLI/CLI.hpp>
 
 /**
- * Print a warning message.
+ * Lock for messages to std::cerr, which may come from several threads at
+ * once.
+ */
+inline std::mutex message_mutex;
+
+/**
+ * Print a warning message. The message is formatted first and written
+ * whole, so that it is not interleaved with those of other threads.
  */
 #define warn(msg) \
-    std::cerr << "warning: " << msg << std::endl;
+    { \
+      std::ostringstream message_buf; \
+      message_buf << "warning: " << msg << '\n'; \
+      std::lock_guard message_lock(message_mutex); \
+      std::cerr << message_buf.str() << std::flush; \
+    }
 
 /**
  * Print an error message and exit.
  */
 #define error(msg) \
-    std::cerr << "error: " << msg << std::endl; \
-    exit(EXIT_FAILURE);
+    { \
+      std::ostringstream message_buf; \
+      message_buf << "error: " << msg << '\n'; \
+      std::lock_guard message_lock(message_mutex); \
+      std::cerr << message_buf.str() << std::flush; \
+      exit(EXIT_FAILURE); \
+    }
+
+/**
+ * Hash for strings that supports heterogeneous lookup, so that a
+ * std::string_view can be looked up without copying it into a std::string.
+ */
+struct string_hash {
+  using is_transparent = void;
+
+  size_t operator()(const std::string_view& str) const {
+    return std::hash<std::string_view>()(str);
+  }
+};
+
+/**
+ * Map from string to string, supporting heterogeneous lookup.
+ */
+using string_map = std::unordered_map<std::string,std::string,string_hash,
+    std::equal_to<>>;
 
 /**
  * Contents of initial doxide.yaml
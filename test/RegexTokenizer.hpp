@@ -0,0 +1,98 @@
+#pragma once
+
+#include "doxide.hpp"
+#include "Token.hpp"
+
+/**
+ * Tokenizer by regular expressions, as Tokenizer was before it became a
+ * hand-written scanner. Kept as the reference for that scanner, which must
+ * give the same tokens for comments that are not runs of line comments.
+ */
+class RegexTokenizer {
+public:
+  /**
+   * Constructor.
+   *
+   * @param source Comment to tokenize.
+   */
+  RegexTokenizer(const std::string_view& source) :
+      failed(false),
+      iter(source.cbegin()),
+      end(source.cend()) {
+    //
+  }
+
+  /**
+   * Get the next token.
+   *
+   * @return Next token.
+   *
+   * If no tokens remain, or the next character starts no token, a token
+   * with a type of `NONE` is returned. The latter also sets #failed, as
+   * Tokenizer would exit with an error instead.
+   */
+  Token next() {
+    Token token(NONE, iter, iter);
+    if (iter != end) {
+      for (auto& [type, regex] : regexes()) {
+        std::match_results<std::string_view::const_iterator> match;
+        if (std::regex_search(iter, end, match, regex,
+            std::regex_constants::match_continuous)) {
+          iter += match.length();
+          token.type = type;
+          token.last = iter;
+          return token;
+        }
+      }
+      failed = true;
+    }
+    return token;
+  }
+
+  /**
+   * Did the last call to next() find a character that starts no token?
+   */
+  bool failed;
+
+private:
+  /**
+   * Token patterns. Order is important, as a match to an earlier pattern
+   * precludes a match to a later.
+   */
+  static const std::vector<std::pair<TokenType,std::regex>>& regexes() {
+    static const std::vector<std::pair<TokenType,std::regex>> regexes = {
+      {AFTER_OPEN, std::regex("(?:/\\*\\*|/\\*!|///|//!)<")},
+      {BEFORE_OPEN, std::regex("(?:/\\*\\*|/\\*!|///|//!)")},
+      {CLOSE, std::regex("\\*/")},
+      {COMMAND, std::regex("[@\\\\](?:param(?:\\[(?:in|out|in,out)\\])?|"
+          "\\w+|@|/|f[\\$\\[\\]])")},
+
+      /* the end of a paragraph is either two new lines or one new line
+       * with a command to come */
+      {PARA, std::regex("\\s*\\n[ \t]*(?:\\*(?!/))?[ \t]*(?:(?=@)|"
+          "\\n[ \t]*(?:\\*(?!/))?[ \t]*)")},
+
+      /* the end of a line is one new line, as long as there is not a
+       * command to come (which would denote the end of a paragraph
+       * instead) */
+      {LINE, std::regex("\\s*\\n[ \t]*(?:\\*(?!/))?[ \t]*(?!@)")},
+
+      {SENTENCE, std::regex("[.!?]")},
+      {WHITESPACE, std::regex("\\s+")},
+      {WORD, std::regex("[^@\\s\\*/]+")},
+      {STAR, std::regex("\\*")},
+      {SLASH, std::regex("/")}
+    };
+    return regexes;
+  }
+
+  /**
+   * Iterator over source.
+   */
+  std::string_view::const_iterator iter;
+
+  /**
+   * End of source.
+   */
+  std::string_view::const_iterator end;
+};
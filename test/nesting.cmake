@@ -0,0 +1,36 @@
+# Check that deeply nested input is documented in full, in time linear in
+# its depth. Generates a header with DEPTH nested namespaces, each with a
+# documented class, builds its documentation with DOXIDE in DIR, and checks
+# the page of the innermost namespace. Run as:
+#
+#     cmake -DDOXIDE=path/to/doxide -DDIR=dir -DDEPTH=n -P nesting.cmake
+#
+# The time limit is set on the test, see CMakeLists.txt.
+file(REMOVE_RECURSE ${DIR})
+set(open "")
+set(close "")
+set(page "")
+foreach(i RANGE 1 ${DEPTH})
+  string(APPEND open "namespace a {\n/**\n * Class ${i}.\n */\nstruct c${i} {};\n")
+  string(APPEND close "}\n")
+  string(APPEND page "a/")
+endforeach()
+file(WRITE ${DIR}/nesting.hpp "${open}/**\n * Innermost function.\n */\nvoid f();\n${close}")
+file(WRITE ${DIR}/doxide.yaml "title: Nesting\nfiles:\n  - \"nesting.hpp\"\noutput: docs\n")
+
+execute_process(COMMAND ${DOXIDE} --no-cache build
+    WORKING_DIRECTORY ${DIR}
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "doxide failed with ${result}")
+endif()
+
+set(index ${DIR}/docs/${page}index.md)
+if(NOT EXISTS ${index})
+  message(FATAL_ERROR "no page for the innermost namespace")
+endif()
+file(READ ${index} contents)
+if(NOT contents MATCHES "Innermost function" OR
+    NOT contents MATCHES "c${DEPTH}")
+  message(FATAL_ERROR "innermost namespace is not documented in full")
+endif()
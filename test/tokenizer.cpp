@@ -0,0 +1,168 @@
+/**
+ * Test of Tokenizer against RegexTokenizer, the regular expressions that it
+ * replaced. Both must give the same tokens for many random strings built
+ * from the characters and sequences that matter to the token patterns, and
+ * for every comment in the source files given as arguments.
+ *
+ * Strings on which the regular expressions find no token are skipped, as
+ * Tokenizer exits with an error on them, as they did.
+ *
+ * The regular expressions have no mode for runs of line comments, in which
+ * the opening of each line after the first is decoration. Tokenizer is
+ * checked against fixed tokens for that instead.
+ */
+#include "Tokenizer.hpp"
+#include "RegexTokenizer.hpp"
+
+/**
+ * Print a string with its control characters escaped.
+ */
+static std::string escape(const std::string_view& str) {
+  std::string out;
+  for (char c : str) {
+    switch (c) {
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    case '\v': out += "\\v"; break;
+    case '\f': out += "\\f"; break;
+    default: out += c;
+    }
+  }
+  return out;
+}
+
+/**
+ * Number of strings compared, skipped, and mismatched.
+ */
+static int compared = 0, skipped = 0, mismatched = 0;
+
+/**
+ * Compare the tokens of both tokenizers for a string.
+ */
+static void compare(const std::string_view& source) {
+  std::vector<Token> expected;
+  RegexTokenizer reference(source);
+  for (Token token = reference.next(); token.type; token = reference.next()) {
+    expected.push_back(token);
+  }
+  if (reference.failed) {
+    ++skipped;
+    return;
+  }
+
+  ++compared;
+  Tokenizer tokenizer(source);
+  for (size_t i = 0; i <= expected.size(); ++i) {
+    Token token = tokenizer.next();
+    bool last = i == expected.size();
+    if (last ? token.type != NONE : (token.type != expected[i].type ||
+        token.str() != expected[i].str())) {
+      if (mismatched++ < 10) {
+        std::cerr << "mismatch at token " << i << " of \"" << escape(source) <<
+            "\": expected " << (last ? NONE : expected[i].type) << " \"" <<
+            escape(last ? "" : expected[i].str()) << "\", got " <<
+            token.type << " \"" << escape(token.str()) << "\"" << std::endl;
+      }
+      return;
+    }
+  }
+}
+
+/**
+ * Compare the tokens of Tokenizer for a string with the given tokens.
+ */
+static void expect(const std::string_view& source, const bool lines,
+    const std::vector<std::pair<TokenType,std::string_view>>& expected) {
+  ++compared;
+  Tokenizer tokenizer(source, lines);
+  for (size_t i = 0; i <= expected.size(); ++i) {
+    Token token = tokenizer.next();
+    bool last = i == expected.size();
+    if (last ? token.type != NONE : (token.type != expected[i].first ||
+        token.str() != expected[i].second)) {
+      ++mismatched;
+      std::cerr << "mismatch at token " << i << " of \"" << escape(source) <<
+          "\" with lines = " << lines << ": expected " <<
+          (last ? NONE : expected[i].first) << " \"" <<
+          escape(last ? "" : expected[i].second) << "\", got " <<
+          token.type << " \"" << escape(token.str()) << "\"" << std::endl;
+      return;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  /* runs of line comments, where the opening of each line is decoration,
+   * but a star is not */
+  expect("/// a\n/// b\n//! c", true, {{BEFORE_OPEN, "///"},
+      {WHITESPACE, " "}, {WORD, "a"}, {LINE, "\n/// "}, {WORD, "b"},
+      {LINE, "\n//! "}, {WORD, "c"}});
+  expect("///< a\n///< b", true, {{AFTER_OPEN, "///<"}, {WHITESPACE, " "},
+      {WORD, "a"}, {LINE, "\n///< "}, {WORD, "b"}});
+  expect("/// a\n///\n/// @b c", true, {{BEFORE_OPEN, "///"},
+      {WHITESPACE, " "}, {WORD, "a"}, {PARA, "\n///\n/// "},
+      {COMMAND, "@b"}, {WHITESPACE, " "}, {WORD, "c"}});
+  expect("/// * a\n/// b", true, {{BEFORE_OPEN, "///"}, {WHITESPACE, " "},
+      {STAR, "*"}, {WHITESPACE, " "}, {WORD, "a"}, {LINE, "\n/// "},
+      {WORD, "b"}});
+
+  /* otherwise, the opening of a line comment is kept, e.g. in code */
+  expect("/** @code\n /// x\n * y\n @endcode */", false,
+      {{BEFORE_OPEN, "/**"}, {WHITESPACE, " "}, {COMMAND, "@code"},
+      {LINE, "\n "}, {BEFORE_OPEN, "///"}, {WHITESPACE, " "}, {WORD, "x"},
+      {LINE, "\n * "}, {WORD, "y"}, {PARA, "\n "}, {COMMAND, "@endcode"},
+      {WHITESPACE, " "}, {CLOSE, "*/"}});
+
+  /* random strings, deterministic across runs */
+  static const std::string_view chars =
+      "/*!<@\\param[],inoutf$ \t\n\r\v\f.?xz_1";
+  static const std::string_view seqs[] = {"@param", "\\param[in,out]",
+      "@param[in]", "param[out]", "/**<", "///", "//!<", "*/", "@f$",
+      "\n * ", "\n *\n", "\n   @", "\n\n", "\r\n"};
+  std::mt19937 rng(42);
+  for (int i = 0; i < 100000; ++i) {
+    std::string source;
+    int len = rng() % 24;
+    for (int j = 0; j < len; ++j) {
+      if (rng() % 5 == 0) {
+        source += seqs[rng() % std::size(seqs)];
+      } else {
+        source += chars[rng() % chars.size()];
+      }
+    }
+    compare(source);
+  }
+
+  /* comments of the given files */
+  int comments = 0;
+  for (int a = 1; a < argc; ++a) {
+    std::ifstream in(argv[a]);
+    std::stringstream buf;
+    buf << in.rdbuf();
+    std::string source = buf.str();
+    for (size_t first = source.find('/'); first != std::string::npos;
+        first = source.find('/', first + 1)) {
+      size_t last = std::string::npos;
+      if (source.compare(first, 2, "/*") == 0) {
+        last = source.find("*/", first + 2);
+        if (last != std::string::npos) {
+          last += 2;
+        }
+      } else if (source.compare(first, 2, "//") == 0) {
+        last = source.find('\n', first);
+      }
+      if (last != std::string::npos) {
+        compare(std::string_view(source).substr(first, last - first));
+        ++comments;
+        first = last - 1;
+      }
+    }
+  }
+
+  std::cout << compared << " compared, " << skipped << " skipped, " <<
+      mismatched << " mismatched, including " << comments <<
+      " comments from " << (argc - 1) << " files" << std::endl;
+  return (mismatched > 0 || (argc > 1 && comments == 0)) ?
+      EXIT_FAILURE : EXIT_SUCCESS;
+}